@@ -0,0 +1,47 @@
+#!/usr/bin/env python3
+"""Ядра над массивами: лучшее из трёх время при -O2 и векторизован ли цикл.
+
+Запуск: bench/kernels/run.py [--bsq build/bsq] [--lli lli] [ключи bsq...]
+"""
+
+import argparse
+import pathlib
+import shutil
+import subprocess
+import tempfile
+import time
+
+HERE = pathlib.Path(__file__).resolve().parent
+
+
+def run_kernel(source, bsq, lli, flags):
+    with tempfile.TemporaryDirectory() as work:
+        program = pathlib.Path(work) / source.name
+        shutil.copy(source, program)
+        subprocess.run([bsq, '-O2', *flags, program], check=True, stdout=subprocess.DEVNULL)
+        ir = program.with_suffix('.ll')
+        is_vectorized = any(line.startswith('vector.body') for line in ir.read_text().splitlines())
+
+        best = float('inf')
+        for _ in range(3):
+            with open(source.with_suffix('.in'), 'rb') as stdin:
+                start = time.perf_counter()
+                subprocess.run([lli, ir], check=True, stdin=stdin, stdout=subprocess.DEVNULL)
+                best = min(best, time.perf_counter() - start)
+        return best, is_vectorized
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument('--bsq', default='build/bsq')
+    parser.add_argument('--lli', default='lli')
+    arguments, flags = parser.parse_known_args()
+
+    bsq = pathlib.Path(arguments.bsq).resolve()
+    for source in sorted(HERE.glob('*.bas')):
+        best, is_vectorized = run_kernel(source, bsq, arguments.lli, flags)
+        print(f'{source.stem:<10} {best:6.2f}s  vectorized: {"yes" if is_vectorized else "no"}')
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,16 @@
+' B(i) = B(i) + A(i) * 0.5 по целому счётчику
+SUB Main
+  INPUT n
+  INPUT m
+  DIM A(n)
+  DIM B(n)
+  FOR i = 1 TO n + 1
+    LET A(i) = i
+  END FOR
+  FOR r = 0 TO m
+    FOR i = 1 TO n + 1
+      LET B(i) = B(i) + A(i) * 0.5
+    END FOR
+  END FOR
+  PRINT B(n)
+END SUB
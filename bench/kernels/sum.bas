@@ -0,0 +1,10 @@
+' Сумма по дробному счётчику: ограничена цепочкой сложений s
+SUB Main
+  INPUT a
+  INPUT m
+  LET s = 0
+  FOR x = a TO a + m STEP 0.25
+    LET s = s + x
+  END FOR
+  PRINT s
+END SUB
@@ -0,0 +1,17 @@
+' Таблица x * x + r по дробному счётчику; индекс — INTEGER
+SUB Main
+  INPUT n
+  INPUT m
+  INPUT h
+  DIM A(n)
+  LET s = 0
+  FOR r = 0 TO m
+    LET j% = 1
+    FOR x = 0 TO n * h STEP 0.5
+      LET A(j%) = x * x + r
+      LET j% = j% + 1
+    END FOR
+    LET s = s + A(n)
+  END FOR
+  PRINT s
+END SUB
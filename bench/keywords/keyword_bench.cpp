@@ -0,0 +1,96 @@
+// Стоимость распознавания ключевых слов на один идентификатор:
+// прежний поиск в std::map по построенной std::string и ClassifyWord.
+//
+// Запуск: build/bsq-keyword-bench [число слов]
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "keywords.hpp"
+
+
+namespace {
+
+using namespace bsq;
+
+/// Идентификаторы из tests/ и похожие на ключевые слова
+constexpr std::string_view kIdentifiers[] = {
+	"i", "j", "k", "n", "x", "y", "A", "tmp", "max", "sum", "Main", "Half%",
+	"e$", "MID$", "STR$", "SQR", "FIX%", "CDBL", "counter", "total", "AAAAAAAAAAAAAAAAAA",
+	"ELSEIFX", "END$", "Step", "TOTAL", "FORM", "IFS", "SUBTOTAL",
+};
+
+constexpr int kRuns = 5;
+
+/// Слова из kKeywords и kIdentifiers поровну, в случайном порядке
+std::vector<std::string_view> sMakeCorpus(std::size_t size) {
+	std::vector<std::string_view> words;
+	for (const auto& keyword : kKeywords) {
+		words.push_back(keyword.name);
+	}
+	words.insert(words.end(), std::begin(kIdentifiers), std::end(kIdentifiers));
+
+	std::mt19937 random{2022};
+	std::uniform_int_distribution<std::size_t> index{0, words.size() - 1};
+	std::vector<std::string_view> corpus(size);
+	std::generate(corpus.begin(), corpus.end(), [&] { return words[index(random)]; });
+	return corpus;
+}
+
+/// Лучшее из kRuns время одного слова в наносекундах; @p checksum — сумма
+/// лексем, чтобы классификация не была выброшена и результаты сравнивались
+template <typename Classify>
+double sMeasure(const std::vector<std::string_view>& corpus, Classify classify, std::size_t& checksum) {
+	auto best = std::chrono::nanoseconds::max();
+	for (int run = 0; run < kRuns; ++run) {
+		checksum = 0;
+		const auto start = std::chrono::steady_clock::now();
+		for (auto word : corpus) {
+			checksum += static_cast<std::size_t>(classify(word));
+		}
+		best = std::min(best, std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start));
+	}
+	return static_cast<double>(best.count()) / static_cast<double>(corpus.size());
+}
+
+}  // namespace
+
+
+
+int main(int argc, char* argv[]) {
+	const std::size_t size = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1 << 22;
+	const auto corpus = sMakeCorpus(size);
+
+	// как LexemeReader::keywords_ и ReadIdentifier_ до совершенного хеша
+	std::map<std::string_view, Token> keywords;
+	for (const auto& keyword : kKeywords) {
+		keywords.emplace(keyword.name, keyword.token);
+	}
+	std::size_t map_checksum = 0;
+	const auto map_time = sMeasure(corpus, [&](std::string_view word) {
+		const std::string value{word};
+		const auto it = keywords.find(value);
+		return it == keywords.end() ? Token::kIdentifier : it->second;
+	}, map_checksum);
+
+	std::size_t hash_checksum = 0;
+	const auto hash_time = sMeasure(corpus, ClassifyWord, hash_checksum);
+
+	std::cout << "слов: " << corpus.size() << '\n'
+		<< "std::map и std::string: " << map_time << " нс/слово\n"
+		<< "ClassifyWord:           " << hash_time << " нс/слово\n";
+
+	if (map_checksum != hash_checksum) {
+		std::cerr << "способы классифицируют слова по-разному" << std::endl;
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,48 @@
+#!/usr/bin/env python3
+"""Ускорение разбора с числом ядер.
+
+bsq запускается на программе generate.py, привязанный к первым 1, 2, 4, ...
+ядрам: столько потоков получает его пул, см. llvm::hardware_concurrency.
+Печатает лучшее из трёх время фазы parse и ускорение относительно
+одного ядра.
+
+Запуск: bench/parse/cores.py [--bsq build/bsq] [--subs 10000]
+        [--expressions 20] [ключи bsq...]
+"""
+
+import argparse
+import os
+import pathlib
+import tempfile
+
+import generate
+import scaling
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument('--bsq', default='build/bsq')
+    parser.add_argument('--subs', type=int, default=10000)
+    parser.add_argument('--locals', type=int, default=4)
+    parser.add_argument('--expressions', type=int, default=20)
+    arguments, flags = parser.parse_known_args()
+
+    bsq = pathlib.Path(arguments.bsq).resolve()
+    available = sorted(os.sched_getaffinity(0))
+    counts = [1 << i for i in range(len(available).bit_length()) if 1 << i < len(available)] + [len(available)]
+
+    with tempfile.TemporaryDirectory() as work:
+        program = pathlib.Path(work) / 'program.bas'
+        with open(program, 'w') as out:
+            generate.generate(arguments.subs, arguments.locals, arguments.expressions, out)
+        print(f'{program.stat().st_size // 1024} КБ, {arguments.subs} SUB')
+
+        single = None
+        for count in counts:
+            best = scaling.parse_time(bsq, program, flags, set(available[:count]))
+            single = single or best
+            print(f'{count:>4} ядер  {best:8.4f}s  ускорение {single / best:5.2f}x')
+
+
+if __name__ == '__main__':
+    main()
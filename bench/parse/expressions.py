@@ -0,0 +1,42 @@
+#!/usr/bin/env python3
+"""Разбор длинных цепочек операций и глубоко вложенных скобок.
+
+Программа из одной SUB с выражением из generate.expression: N операций
+подряд внутри N пар скобок. Печатает лучшее из трёх время фазы parse
+и время на операцию. Скобки разбираются без рекурсии при любой
+глубине, но глубина AST растёт с длиной цепочки, а следующие фазы
+обходят дерево рекурсивно, поэтому длины ограничены их стеком.
+
+Запуск: bench/parse/expressions.py [--bsq build/bsq] [--lengths 1000 10000 50000]
+        [ключи bsq...]
+"""
+
+import argparse
+import pathlib
+import tempfile
+
+import generate
+import scaling
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument('--bsq', default='build/bsq')
+    parser.add_argument('--lengths', type=int, nargs='+', default=[1000, 10000, 50000])
+    arguments, flags = parser.parse_known_args()
+
+    bsq = pathlib.Path(arguments.bsq).resolve()
+    with tempfile.TemporaryDirectory() as work:
+        for length in sorted(arguments.lengths):
+            program = pathlib.Path(work) / f'expression{length}.bas'
+            program.write_text(
+                'SUB Main\n'
+                '  LET x = 1\n'
+                f'  PRINT {generate.expression("x", length, length)}\n'
+                'END SUB\n')
+            best = scaling.parse_time(bsq, program, flags)
+            print(f'{length:>7} операций  {best:8.4f}s  {best / length * 1e9:7.1f} нс/операцию')
+
+
+if __name__ == '__main__':
+    main()
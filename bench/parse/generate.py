@@ -0,0 +1,52 @@
+#!/usr/bin/env python3
+"""Синтетическая программа для замеров разбора.
+
+Каждая SUB вызывает следующую, ещё не объявленную, — так работают
+неразрешённые ссылки, — и заводит --locals локальных переменных.
+--expressions задаёт длину цепочки операций и глубину скобок
+в каждой SUB; 0 — короткие выражения.
+
+Запуск: bench/parse/generate.py --subs 10000 > program.bas
+"""
+
+import argparse
+import sys
+
+
+def expression(name, length, depth):
+    # длинная плоская цепочка операций разных приоритетов
+    operators = ['+', '*', '-', '/']
+    chain = ' '.join(f'{name} {operators[i % len(operators)]}' for i in range(length)) + ' 1'
+    # глубоко вложенные скобки
+    return '(' * depth + chain + ')' * depth
+
+
+def generate(subs, locals_count, expressions, out):
+    for i in range(subs):
+        out.write(f'SUB s{i}(x)\n')
+        for j in range(locals_count):
+            out.write(f'  LET v{j} = x + {j}\n')
+        if expressions > 0:
+            out.write(f'  LET e = {expression("x", expressions, expressions)}\n')
+        if i + 1 < subs:
+            out.write(f'  LET s{i} = s{i + 1}(x) + 1\n')
+        else:
+            out.write(f'  LET s{i} = x\n')
+        out.write('END SUB\n\n')
+
+    out.write('SUB Main\n')
+    out.write('  PRINT s0(0)\n')
+    out.write('END SUB\n')
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument('--subs', type=int, default=10000)
+    parser.add_argument('--locals', type=int, default=4)
+    parser.add_argument('--expressions', type=int, default=0)
+    arguments = parser.parse_args()
+    generate(arguments.subs, arguments.locals, arguments.expressions, sys.stdout)
+
+
+if __name__ == '__main__':
+    main()
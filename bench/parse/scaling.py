@@ -0,0 +1,65 @@
+#!/usr/bin/env python3
+"""Рост времени разбора с числом SUB в программе generate.py.
+
+Для каждого размера печатает лучшее из трёх время фазы parse
+из --time-report=json и время на одну SUB. Разбор линеен, если время
+на SUB почти не растёт; при росте больше --limit раз между наименьшей
+и наибольшей программой скрипт завершается с кодом 1.
+
+Запуск: bench/parse/scaling.py [--bsq build/bsq] [--subs 1250 2500 5000 10000]
+        [--locals 4] [--expressions 0] [ключи bsq...]
+"""
+
+import argparse
+import json
+import os
+import pathlib
+import subprocess
+import sys
+import tempfile
+
+import generate
+
+
+def parse_time(bsq, program, flags, cores=None):
+    """Лучшее из трёх время фазы parse; cores — ядра, к которым привязан bsq"""
+    best = float('inf')
+    for _ in range(3):
+        result = subprocess.run(
+            [bsq, '-O0', '--time-report=json', *flags, program],
+            check=True, capture_output=True, text=True,
+            preexec_fn=None if cores is None else lambda: os.sched_setaffinity(0, cores))
+        report = json.loads(result.stdout.splitlines()[0])
+        best = min(best, report['phases']['parse']['wall'])
+    return best
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument('--bsq', default='build/bsq')
+    parser.add_argument('--subs', type=int, nargs='+', default=[1250, 2500, 5000, 10000])
+    parser.add_argument('--locals', type=int, default=4)
+    parser.add_argument('--expressions', type=int, default=0)
+    parser.add_argument('--limit', type=float, default=2.0)
+    arguments, flags = parser.parse_known_args()
+
+    bsq = pathlib.Path(arguments.bsq).resolve()
+    per_sub = []
+    with tempfile.TemporaryDirectory() as work:
+        for subs in sorted(arguments.subs):
+            program = pathlib.Path(work) / f'subs{subs}.bas'
+            with open(program, 'w') as out:
+                generate.generate(subs, arguments.locals, arguments.expressions, out)
+            best = parse_time(bsq, program, flags)
+            per_sub.append(best / subs)
+            print(f'{subs:>7} SUB  {best:8.4f}s  {per_sub[-1] * 1e6:7.2f} мкс/SUB')
+
+    growth = per_sub[-1] / per_sub[0]
+    print(f'рост времени на SUB: {growth:.2f}x')
+    if growth > arguments.limit:
+        print(f'разбор растёт быстрее линейного: больше {arguments.limit}x', file=sys.stderr)
+        sys.exit(1)
+
+
+if __name__ == '__main__':
+    main()
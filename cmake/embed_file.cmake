@@ -0,0 +1,23 @@
+# Превращает файл INPUT в исходный текст C++ OUTPUT, в котором содержимое
+# файла — массив байт bsq::NAME, а его размер — bsq::NAMESize.
+#
+# cmake -DINPUT=<файл> -DOUTPUT=<файл.cpp> -DNAME=<имя> -P embed_file.cmake
+
+file(READ "${INPUT}" content HEX)
+string(REGEX REPLACE "([0-9a-f][0-9a-f])" "0x\\1," bytes "${content}")
+string(REGEX REPLACE "((0x[0-9a-f][0-9a-f],){16})" "\\1\n\t" bytes "${bytes}")
+
+file(WRITE "${OUTPUT}" "// Создан из ${INPUT} сценарием embed_file.cmake
+
+#include <cstddef>
+
+
+namespace bsq {
+
+extern const unsigned char ${NAME}[] = {
+	${bytes}
+};
+extern const std::size_t ${NAME}Size = sizeof(${NAME});
+
+}  // namespace bsq
+")
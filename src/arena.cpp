@@ -0,0 +1,64 @@
+#include "arena.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+
+
+namespace bsq {
+
+Arena::~Arena() {
+	for (auto it = destructors_.rbegin(); it != destructors_.rend(); ++it) {
+		it->destroy(it->object);
+	}
+}
+
+std::string_view Arena::Intern(std::string_view text) {
+	if (auto it = interned_.find(text); it != interned_.end()) {
+		return *it;
+	}
+
+	auto* memory = static_cast<char*>(Allocate(text.size(), alignof(char)));
+	std::copy(text.begin(), text.end(), memory);
+
+	std::string_view interned{memory, text.size()};
+	interned_.insert(interned);
+	return interned;
+}
+
+void* Arena::Allocate(size_t size, size_t alignment) {
+	auto address = reinterpret_cast<std::uintptr_t>(current_);
+	auto aligned = (address + alignment - 1) & ~(alignment - 1);
+
+	if (current_ == nullptr || aligned + size > reinterpret_cast<std::uintptr_t>(end_)) {
+		// крупные объекты получают отдельный блок
+		const auto block_size = std::max(kBlockSize, size + alignment);
+		blocks_.push_back(std::make_unique_for_overwrite<std::byte[]>(block_size));
+		capacity_ += block_size;
+
+		current_ = blocks_.back().get();
+		end_ = current_ + block_size;
+
+		address = reinterpret_cast<std::uintptr_t>(current_);
+		aligned = (address + alignment - 1) & ~(alignment - 1);
+	}
+
+	current_ += aligned - address + size;
+	return reinterpret_cast<void*>(aligned);
+}
+
+void Arena::Adopt(Arena& other) {
+	blocks_.insert(blocks_.end(), std::make_move_iterator(other.blocks_.begin()), std::make_move_iterator(other.blocks_.end()));
+	destructors_.insert(destructors_.end(), other.destructors_.begin(), other.destructors_.end());
+	interned_.merge(other.interned_);
+	capacity_ += other.capacity_;
+
+	other.blocks_.clear();
+	other.destructors_.clear();
+	other.interned_.clear();
+	other.current_ = nullptr;
+	other.end_ = nullptr;
+	other.capacity_ = 0;
+}
+
+}  // namespace bsq
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <string_view>
+#include <type_traits>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+
+namespace bsq {
+
+/// @brief Арена: линейный (bump) распределитель памяти
+///
+/// Объекты размещаются подряд в крупных блоках и освобождаются все разом
+/// при разрушении арены. Деструкторы вызываются только для объектов,
+/// которым они нужны, в порядке, обратном созданию.
+class Arena {
+public:
+	Arena() = default;
+	Arena(const Arena&) = delete;
+	Arena& operator=(const Arena&) = delete;
+	~Arena();
+
+	template <typename T, typename... Args>
+	T* Make(Args&& ... args) {
+		auto* object = ::new (Allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+		if constexpr (!std::is_trivially_destructible_v<T>) {
+			destructors_.push_back({object, [](void* p) { static_cast<T*>(p)->~T(); }});
+		}
+		return object;
+	}
+
+	/// Копирует строку в арену; одинаковые строки хранятся в одном экземпляре
+	std::string_view Intern(std::string_view text);
+
+	void* Allocate(size_t size, size_t alignment);
+
+	/// Забирает блоки и объекты арены @p other: они будут освобождены
+	/// вместе с этой ареной, а @p other становится пустой
+	void Adopt(Arena& other);
+
+	/// Суммарный объём выделенных блоков
+	[[nodiscard]] size_t GetCapacity() const { return capacity_; }
+
+private:
+	static constexpr size_t kBlockSize = 64 * 1024;
+
+	struct Destructor {
+		void* object;
+		void (*destroy)(void*);
+	};
+
+	std::vector<std::unique_ptr<std::byte[]>> blocks_;
+	std::byte* current_ = nullptr;
+	std::byte* end_ = nullptr;
+	size_t capacity_ = 0;
+
+	std::vector<Destructor> destructors_;
+	std::unordered_set<std::string_view> interned_;
+};
+
+}  // namespace bsq
@@ -1,8 +1,126 @@
 #include "ast.hpp"
 
 
+namespace {
+
+using namespace bsq;
+
+/// Обходит дерево и считает узлы, кроме переменных
+class AstNodeCounter {
+public:
+	explicit AstNodeCounter(AstNodeCounts& counts)
+		: counts_{counts}
+	{
+	}
+
+	void Count(StatementAstNodePtr node) {
+		if (node != nullptr) {
+			++counts_[static_cast<size_t>(node->GetNodeType())];
+			VisitStatement(node, *this);
+		}
+	}
+
+	void Count(ExpressionAstNodePtr node) {
+		// переменные считаются по спискам локальных переменных подпрограмм
+		if (node != nullptr && !AstNodeIs<VariableAstNode>(node)) {
+			++counts_[static_cast<size_t>(node->GetNodeType())];
+			VisitExpression(node, *this);
+		}
+	}
+
+	void operator()(SequenceAstNodePtr node) {
+		for (auto* item : node->items) {
+			Count(item);
+		}
+	}
+
+	void operator()(InputAstNodePtr node) {
+		Count(node->prompt);
+		Count(node->item);
+	}
+
+	void operator()(PrintAstNodePtr node) { Count(node->expression); }
+
+	void operator()(LetAstNodePtr node) {
+		Count(node->expression);
+		Count(node->array_index);
+	}
+
+	void operator()(DimAstNodePtr node) { Count(node->size); }
+
+	void operator()(IfAstNodePtr node) {
+		Count(node->condition);
+		Count(node->then);
+		Count(node->otherwise);
+	}
+
+	void operator()(WhileAstNodePtr node) {
+		Count(node->condition);
+		Count(node->body);
+	}
+
+	void operator()(ForAstNodePtr node) {
+		Count(node->begin);
+		Count(node->end);
+		Count(node->step);
+		Count(node->body);
+	}
+
+	void operator()(CallAstNodePtr node) { Count(node->subroutine_call); }
+
+	void operator()(ItemAstNodePtr node) { Count(node->expression); }
+	void operator()(UnaryExpressionAstNodePtr node) { Count(node->GetOperand()); }
+
+	void operator()(BinaryExpressionAstNodePtr node) {
+		Count(node->GetLeftOperand());
+		Count(node->GetRightOperand());
+	}
+
+	void operator()(ApplyAstNodePtr node) {
+		for (auto* argument : node->GetArguments()) {
+			Count(argument);
+		}
+	}
+
+	/// Листья: константы и переменные
+	template <typename T>
+	void operator()(T*) {}
+
+private:
+	AstNodeCounts& counts_;
+};
+
+}  // namespace
+
+
 namespace bsq {
 
+std::string ToString(AstNodeType type) {
+	switch (type) {
+	case AstNodeType::kEmpty: return "Empty";
+	case AstNodeType::kBoolean: return "Boolean";
+	case AstNodeType::kNumber: return "Number";
+	case AstNodeType::kText: return "Text";
+	case AstNodeType::kVariable: return "Variable";
+	case AstNodeType::kUnary: return "Unary";
+	case AstNodeType::kBinary: return "Binary";
+	case AstNodeType::kApply: return "Apply";
+	case AstNodeType::kSequence: return "Sequence";
+	case AstNodeType::kInput: return "Input";
+	case AstNodeType::kPrint: return "Print";
+	case AstNodeType::kLet: return "Let";
+	case AstNodeType::kDim: return "Dim";
+	case AstNodeType::kItem: return "Item";
+	case AstNodeType::kIf: return "If";
+	case AstNodeType::kWhile: return "While";
+	case AstNodeType::kFor: return "For";
+	case AstNodeType::kCall: return "Call";
+	case AstNodeType::kSubroutine: return "Subroutine";
+	case AstNodeType::kProgram: return "Program";
+	default: return "UNDEFINED";
+	}
+}
+
 std::string ToString(Operation opc) {
 	switch (opc) {
 	case Operation::kNone: return "None";
@@ -10,7 +128,8 @@ std::string ToString(Operation opc) {
 	case Operation::kSub: return "-";
 	case Operation::kMul: return "*";
 	case Operation::kDiv: return "/";
-	case Operation::kMod: return "\\";
+	case Operation::kIntDiv: return "\\";
+	case Operation::kMod: return "MOD";
 	case Operation::kPow: return "^";
 	case Operation::kEq: return "=";
 	case Operation::kNe: return "<>";
@@ -35,18 +154,43 @@ DataType GetIdentifierType(std::string_view name) {
 		return DataType::kTextual;
 	}
 
+	if (name.ends_with('%')) {
+		return DataType::kInteger;
+	}
+
 	return DataType::kNumeric;
 }
 
+std::string_view NormalizeIdentifier(std::string_view name) {
+	if (name.ends_with('$') || name.ends_with('?') || name.ends_with('%')) {
+		name.remove_suffix(1);
+	}
+	return name;
+}
+
 std::string ToString(DataType type) {
 	switch (type) {
 	case DataType::kVoid: return "VOID";
 	case DataType::kBoolean: return "BOOLEAN";
 	case DataType::kNumeric: return "NUMBER";
+	case DataType::kInteger: return "INTEGER";
 	case DataType::kTextual: return "TEXT";
 	case DataType::kArray: return "ARRAY";
 	default: return "UNDEFINED";
 	}
 }
 
+AstNodeCounts CountAstNodes(ProgramAstNodeCPtr program) {
+	AstNodeCounts counts{};
+	++counts[static_cast<size_t>(AstNodeType::kProgram)];
+
+	AstNodeCounter counter{counts};
+	for (auto* subroutine : program->subroutines) {
+		++counts[static_cast<size_t>(AstNodeType::kSubroutine)];
+		counts[static_cast<size_t>(AstNodeType::kVariable)] += subroutine->local_variables.size();
+		counter.Count(subroutine->body);
+	}
+	return counts;
+}
+
 }  // namespace bsq
@@ -1,11 +1,17 @@
 #pragma once
 
+#include <array>
+#include <cmath>
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <string_view>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
+#include "arena.hpp"
+
 
 namespace bsq {
 
@@ -32,6 +38,8 @@ enum class AstNodeType {
 	kProgram,
 };
 
+std::string ToString(AstNodeType type);
+
 
 class AstNode {
 public:
@@ -40,21 +48,25 @@ public:
 	{
 	}
 
-	virtual ~AstNode() = default;
-
 	[[nodiscard]] AstNodeType GetNodeType() const { return node_type_; }
 
+protected:
+	// Узлы не полиморфны: тип определяется по node_type_, а разрушает
+	// их арена, знающая настоящий тип каждого объекта.
+	~AstNode() = default;
+
 private:
 	AstNodeType node_type_;
 };
 
-using AstNodePtr = std::shared_ptr<AstNode>;
-using AstNodeCPtr = std::shared_ptr<const AstNode>;
+using AstNodePtr = AstNode*;
+using AstNodeCPtr = const AstNode*;
 
 
+/// Создаёт узел в арене @p arena; узел живёт, пока жива арена
 template <typename P, typename... Args>
-std::shared_ptr<P> MakeAstNode(Args&& ... args) {
-	return std::make_shared<P>(std::forward<Args>(args)...);
+P* MakeAstNode(Arena& arena, Args&& ... args) {
+	return arena.Make<P>(std::forward<Args>(args)...);
 }
 
 
@@ -62,6 +74,7 @@ enum class DataType : char {
 	kVoid = 'V',
 	kBoolean = 'B',
 	kNumeric = 'N',
+	kInteger = 'I',
 	kTextual = 'T',
 	kArray = 'A',
 };
@@ -71,8 +84,11 @@ enum class DataType : char {
 /// Тип идентификатора определяется следующим образом:
 /// - если он заканчивается на '$' — текстовый;
 /// - если он заканчивается на '?' — логический;
+/// - если он заканчивается на '%' — целый (64 бита);
 /// - иначе — числовой.
 DataType GetIdentifierType(std::string_view name);
+/// Имя без суффикса типа: 'a$', 'a?', 'a%' и 'a' — одно и то же имя
+std::string_view NormalizeIdentifier(std::string_view name);
 std::string ToString(DataType type);
 
 
@@ -94,14 +110,16 @@ private:
 	DataType type_;
 };
 
-using ExpressionAstNodePtr = std::shared_ptr<ExpressionAstNode>;
-using ExpressionAstNodeCPtr = std::shared_ptr<const ExpressionAstNode>;
+using ExpressionAstNodePtr = ExpressionAstNode*;
+using ExpressionAstNodeCPtr = const ExpressionAstNode*;
 
 
 class BooleanAstNode : public ExpressionAstNode {
 public:
+	static constexpr AstNodeType kNodeType = AstNodeType::kBoolean;
+
 	explicit BooleanAstNode(bool value)
-		: ExpressionAstNode{AstNodeType::kBoolean, DataType::kBoolean}
+		: ExpressionAstNode{kNodeType, DataType::kBoolean}
 		, value_{value}
 	{
 	}
@@ -112,69 +130,101 @@ private:
 	bool value_;
 };
 
-using BooleanAstNodePtr = std::shared_ptr<BooleanAstNode>;
+using BooleanAstNodePtr = BooleanAstNode*;
 
 
+/// @brief Числовой литерал
+///
+/// Литерал с целым значением в пределах int64 становится INTEGER, если
+/// этого требует контекст (см. SemanticChecker). Целое значение хранится
+/// отдельно: double не представляет точно целые больше 2^53.
 class NumberAstNode : public ExpressionAstNode {
 public:
+	static constexpr AstNodeType kNodeType = AstNodeType::kNumber;
+
 	explicit NumberAstNode(double value)
-		: ExpressionAstNode{AstNodeType::kNumber, DataType::kNumeric}
+		: ExpressionAstNode{kNodeType, DataType::kNumeric}
 		, value_{value}
+		, is_integral_{std::trunc(value) == value && value >= -0x1p63 && value < 0x1p63}
+		, integer_value_{is_integral_ ? static_cast<std::int64_t>(value) : 0}
+	{
+	}
+
+	NumberAstNode(double value, std::int64_t integer_value)
+		: ExpressionAstNode{kNodeType, DataType::kNumeric}
+		, value_{value}
+		, is_integral_{true}
+		, integer_value_{integer_value}
 	{
 	}
 
 	[[nodiscard]] double GetValue() const { return value_; }
+	[[nodiscard]] bool IsIntegral() const { return is_integral_; }
+	[[nodiscard]] std::int64_t GetIntegerValue() const { return integer_value_; }
 
 private:
 	double value_;
+	bool is_integral_;
+	std::int64_t integer_value_;
 };
 
-using NumberAstNodePtr = std::shared_ptr<NumberAstNode>;
-using NumberAstNodeCPtr = std::shared_ptr<const NumberAstNode>;
+using NumberAstNodePtr = NumberAstNode*;
+using NumberAstNodeCPtr = const NumberAstNode*;
 
 
 class TextAstNode : public ExpressionAstNode {
 public:
+	static constexpr AstNodeType kNodeType = AstNodeType::kText;
+
 	explicit TextAstNode(std::string_view value)
-		: ExpressionAstNode{AstNodeType::kText, DataType::kTextual}
+		: ExpressionAstNode{kNodeType, DataType::kTextual}
 		, value_{value}
 	{
 	}
 
-	[[nodiscard]] const std::string& GetValue() const { return value_; }
+	[[nodiscard]] std::string_view GetValue() const { return value_; }
 
 private:
-	std::string value_;
+	std::string_view value_;
 };
 
-using TextAstNodePtr = std::shared_ptr<TextAstNode>;
-using TextAstNodeCPtr = std::shared_ptr<const TextAstNode>;
+using TextAstNodePtr = TextAstNode*;
+using TextAstNodeCPtr = const TextAstNode*;
 
 
 class VariableAstNode : public ExpressionAstNode {
 public:
+	static constexpr AstNodeType kNodeType = AstNodeType::kVariable;
+
+	/// Наибольший размер массива, как в bsq_array_alloc: размер в байтах
+	/// не переполняет size_t
+	static constexpr size_t kMaxArraySize = SIZE_MAX / 2 / sizeof(double);
+
 	explicit VariableAstNode(std::string_view name)
-		: ExpressionAstNode{AstNodeType::kVariable, GetIdentifierType(name)}
+		: ExpressionAstNode{kNodeType, GetIdentifierType(name)}
 		, name_{name}
 	{
 	}
 
-	[[nodiscard]] const std::string& GetName() const { return name_; }
+	[[nodiscard]] std::string_view GetName() const { return name_; }
 
+	/// Размер массива; 0 — размер вычисляется при выполнении (DIM n, REDIM)
 	size_t array_size = 0;
 
 private:
-	std::string name_;
+	std::string_view name_;
 };
 
-using VariableAstNodePtr = std::shared_ptr<VariableAstNode>;
-using VariableAstNodeCPtr = std::shared_ptr<const VariableAstNode>;
+using VariableAstNodePtr = VariableAstNode*;
+using VariableAstNodeCPtr = const VariableAstNode*;
 
 
 class ItemAstNode : public ExpressionAstNode {
 public:
+	static constexpr AstNodeType kNodeType = AstNodeType::kItem;
+
 	ItemAstNode(VariableAstNodePtr array, ExpressionAstNodePtr expression)
-		: ExpressionAstNode{AstNodeType::kItem, DataType::kNumeric}
+		: ExpressionAstNode{kNodeType, DataType::kNumeric}
 		, array{std::move(array)}
 		, expression{std::move(expression)}
 	{
@@ -184,8 +234,8 @@ public:
 	ExpressionAstNodePtr expression;
 };
 
-using ItemAstNodePtr = std::shared_ptr<ItemAstNode>;
-using ItemAstNodeCPtr = std::shared_ptr<const ItemAstNode>;
+using ItemAstNodePtr = ItemAstNode*;
+using ItemAstNodeCPtr = const ItemAstNode*;
 
 
 enum class Operation {
@@ -194,6 +244,7 @@ enum class Operation {
 	kSub,
 	kMul,
 	kDiv,
+	kIntDiv,
 	kMod,
 	kPow,
 	kEq,
@@ -213,8 +264,10 @@ std::string ToString(Operation opc);
 
 class UnaryExpressionAstNode : public ExpressionAstNode {
 public:
+	static constexpr AstNodeType kNodeType = AstNodeType::kUnary;
+
 	UnaryExpressionAstNode(Operation operation, ExpressionAstNodePtr operand)
-		: ExpressionAstNode{AstNodeType::kUnary, DataType::kNumeric}
+		: ExpressionAstNode{kNodeType, DataType::kNumeric}
 		, operation_{operation}
 		, operand_{std::move(operand)}
 	{
@@ -222,20 +275,23 @@ public:
 
 	[[nodiscard]] Operation GetOperation() const { return operation_; }
 	[[nodiscard]] const ExpressionAstNodePtr& GetOperand() const { return operand_; }
+	void SetOperand(ExpressionAstNodePtr operand) { operand_ = operand; }
 
 private:
 	Operation operation_;
 	ExpressionAstNodePtr operand_;
 };
 
-using UnaryExpressionAstNodePtr = std::shared_ptr<UnaryExpressionAstNode>;
-using UnaryExpressionAstNodeCPtr = std::shared_ptr<const UnaryExpressionAstNode>;
+using UnaryExpressionAstNodePtr = UnaryExpressionAstNode*;
+using UnaryExpressionAstNodeCPtr = const UnaryExpressionAstNode*;
 
 
 class BinaryExpressionAstNode : public ExpressionAstNode {
 public:
+	static constexpr AstNodeType kNodeType = AstNodeType::kBinary;
+
 	BinaryExpressionAstNode(Operation operation, ExpressionAstNodePtr left_operand, ExpressionAstNodePtr right_operand)
-		: ExpressionAstNode{AstNodeType::kBinary, DataType::kVoid}
+		: ExpressionAstNode{kNodeType, DataType::kVoid}
 		, operation_{operation}
 		, left_operand_{std::move(left_operand)}
 		, right_operand_{std::move(right_operand)}
@@ -245,6 +301,8 @@ public:
 	[[nodiscard]] Operation GetOperation() const { return operation_; }
 	[[nodiscard]] const ExpressionAstNodePtr& GetLeftOperand() const { return left_operand_; }
 	[[nodiscard]] const ExpressionAstNodePtr& GetRightOperand() const { return right_operand_; }
+	void SetLeftOperand(ExpressionAstNodePtr operand) { left_operand_ = operand; }
+	void SetRightOperand(ExpressionAstNodePtr operand) { right_operand_ = operand; }
 
 private:
 	Operation operation_;
@@ -252,20 +310,22 @@ private:
 	ExpressionAstNodePtr right_operand_;
 };
 
-using BinaryExpressionAstNodePtr = std::shared_ptr<BinaryExpressionAstNode>;
-using BinaryExpressionAstNodeCPtr = std::shared_ptr<const BinaryExpressionAstNode>;
+using BinaryExpressionAstNodePtr = BinaryExpressionAstNode*;
+using BinaryExpressionAstNodeCPtr = const BinaryExpressionAstNode*;
 
 
 class SubroutineAstNode;
 
-using SubroutineAstNodePtr = std::shared_ptr<SubroutineAstNode>;
-using SubroutineAstNodeCPtr = std::shared_ptr<const SubroutineAstNode>;
+using SubroutineAstNodePtr = SubroutineAstNode*;
+using SubroutineAstNodeCPtr = const SubroutineAstNode*;
 
 
 class ApplyAstNode : public ExpressionAstNode {
 public:
+	static constexpr AstNodeType kNodeType = AstNodeType::kApply;
+
 	ApplyAstNode(SubroutineAstNodePtr callee, std::vector<ExpressionAstNodePtr> arguments)
-		: ExpressionAstNode{AstNodeType::kApply, DataType::kVoid}
+		: ExpressionAstNode{kNodeType, DataType::kVoid}
 		, callee_{std::move(callee)}
 		, arguments_{std::move(arguments)}
 	{
@@ -275,14 +335,15 @@ public:
 	void SetCallee(SubroutineAstNodePtr callee) { callee_ = std::move(callee); }
 
 	[[nodiscard]] const std::vector<ExpressionAstNodePtr>& GetArguments() const { return arguments_; }
+	void SetArgument(size_t index, ExpressionAstNodePtr argument) { arguments_[index] = argument; }
 
 private:
 	SubroutineAstNodePtr callee_;
 	std::vector<ExpressionAstNodePtr> arguments_;
 };
 
-using ApplyAstNodePtr = std::shared_ptr<ApplyAstNode>;
-using ApplyAstNodeCPtr = std::shared_ptr<const ApplyAstNode>;
+using ApplyAstNodePtr = ApplyAstNode*;
+using ApplyAstNodeCPtr = const ApplyAstNode*;
 
 
 class StatementAstNode : public AstNode {
@@ -293,28 +354,32 @@ public:
 	}
 };
 
-using StatementAstNodePtr = std::shared_ptr<StatementAstNode>;
-using StatementAstNodeCPtr = std::shared_ptr<const StatementAstNode>;
+using StatementAstNodePtr = StatementAstNode*;
+using StatementAstNodeCPtr = const StatementAstNode*;
 
 
 class SequenceAstNode : public StatementAstNode {
 public:
+	static constexpr AstNodeType kNodeType = AstNodeType::kSequence;
+
 	SequenceAstNode()
-		: StatementAstNode{AstNodeType::kSequence}
+		: StatementAstNode{kNodeType}
 	{
 	}
 
 	std::vector<StatementAstNodePtr> items;
 };
 
-using SequenceAstNodePtr = std::shared_ptr<SequenceAstNode>;
-using SequenceAstNodeCPtr = std::shared_ptr<const SequenceAstNode>;
+using SequenceAstNodePtr = SequenceAstNode*;
+using SequenceAstNodeCPtr = const SequenceAstNode*;
 
 
 class InputAstNode : public StatementAstNode {
 public:
+	static constexpr AstNodeType kNodeType = AstNodeType::kInput;
+
 	InputAstNode(TextAstNodePtr prompt, VariableAstNodePtr variable, ItemAstNodePtr item = nullptr)
-		: StatementAstNode{AstNodeType::kInput}
+		: StatementAstNode{kNodeType}
 		, prompt{std::move(prompt)}
 		, variable{std::move(variable)}
 		, item{std::move(item)}
@@ -326,14 +391,16 @@ public:
 	ItemAstNodePtr item;
 };
 
-using InputAstNodePtr = std::shared_ptr<InputAstNode>;
-using InputAstNodeCPtr = std::shared_ptr<const InputAstNode>;
+using InputAstNodePtr = InputAstNode*;
+using InputAstNodeCPtr = const InputAstNode*;
 
 
 class PrintAstNode : public StatementAstNode {
 public:
+	static constexpr AstNodeType kNodeType = AstNodeType::kPrint;
+
 	explicit PrintAstNode(ExpressionAstNodePtr expression)
-		: StatementAstNode{AstNodeType::kPrint}
+		: StatementAstNode{kNodeType}
 		, expression(std::move(expression))
 	{
 	}
@@ -341,14 +408,16 @@ public:
 	ExpressionAstNodePtr expression;
 };
 
-using PrintAstNodePtr = std::shared_ptr<PrintAstNode>;
-using PrintAstNodeCPtr = std::shared_ptr<const PrintAstNode>;
+using PrintAstNodePtr = PrintAstNode*;
+using PrintAstNodeCPtr = const PrintAstNode*;
 
 
 class LetAstNode : public StatementAstNode {
 public:
+	static constexpr AstNodeType kNodeType = AstNodeType::kLet;
+
 	LetAstNode(VariableAstNodePtr variable, ExpressionAstNodePtr expression)
-		: StatementAstNode{AstNodeType::kLet}
+		: StatementAstNode{kNodeType}
 		, variable{std::move(variable)}
 		, expression{std::move(expression)}
 	{
@@ -356,34 +425,41 @@ public:
 
 	VariableAstNodePtr variable;
 	ExpressionAstNodePtr expression;
-	ExpressionAstNodePtr array_index;
+	ExpressionAstNodePtr array_index = nullptr;
 };
 
-using LetAstNodePtr = std::shared_ptr<LetAstNode>;
-using LetAstNodeCPtr = std::shared_ptr<const LetAstNode>;
+using LetAstNodePtr = LetAstNode*;
+using LetAstNodeCPtr = const LetAstNode*;
 
 
+/// DIM или REDIM; REDIM PRESERVE сохраняет элементы массива
 class DimAstNode : public StatementAstNode {
 public:
-	DimAstNode(VariableAstNodePtr variable, NumberAstNodePtr size)
-		: StatementAstNode{AstNodeType::kDim}
+	static constexpr AstNodeType kNodeType = AstNodeType::kDim;
+
+	DimAstNode(VariableAstNodePtr variable, ExpressionAstNodePtr size, bool is_preserving = false)
+		: StatementAstNode{kNodeType}
 		, variable{std::move(variable)}
 		, size{std::move(size)}
+		, is_preserving{is_preserving}
 	{
 	}
 
 	VariableAstNodePtr variable;
-	NumberAstNodePtr size;
+	ExpressionAstNodePtr size;
+	bool is_preserving;
 };
 
-using DimAstNodePtr = std::shared_ptr<DimAstNode>;
-using DimAstNodeCPtr = std::shared_ptr<const DimAstNode>;
+using DimAstNodePtr = DimAstNode*;
+using DimAstNodeCPtr = const DimAstNode*;
 
 
 class IfAstNode : public StatementAstNode {
 public:
+	static constexpr AstNodeType kNodeType = AstNodeType::kIf;
+
 	IfAstNode(ExpressionAstNodePtr condition, StatementAstNodePtr then, StatementAstNodePtr otherwise = nullptr)
-		: StatementAstNode{AstNodeType::kIf}
+		: StatementAstNode{kNodeType}
 		, condition{std::move(condition)}
 		, then{std::move(then)}
 		, otherwise{std::move(otherwise)}
@@ -395,14 +471,16 @@ public:
 	StatementAstNodePtr otherwise;
 };
 
-using IfAstNodePtr = std::shared_ptr<IfAstNode>;
-using IfAstNodeCPtr = std::shared_ptr<const IfAstNode>;
+using IfAstNodePtr = IfAstNode*;
+using IfAstNodeCPtr = const IfAstNode*;
 
 
 class WhileAstNode : public StatementAstNode {
 public:
+	static constexpr AstNodeType kNodeType = AstNodeType::kWhile;
+
 	WhileAstNode(ExpressionAstNodePtr condition, StatementAstNodePtr body)
-		: StatementAstNode{AstNodeType::kWhile}
+		: StatementAstNode{kNodeType}
 		, condition{std::move(condition)}
 		, body{std::move(body)}
 	{
@@ -412,12 +490,14 @@ public:
 	StatementAstNodePtr body;
 };
 
-using WhileAstNodePtr = std::shared_ptr<WhileAstNode>;
-using WhileAstNodeCPtr = std::shared_ptr<WhileAstNode>;
+using WhileAstNodePtr = WhileAstNode*;
+using WhileAstNodeCPtr = const WhileAstNode*;
 
 
 class ForAstNode : public StatementAstNode {
 public:
+	static constexpr AstNodeType kNodeType = AstNodeType::kFor;
+
 	ForAstNode(
 		VariableAstNodePtr variable,
 		ExpressionAstNodePtr begin,
@@ -425,7 +505,7 @@ public:
 		NumberAstNodePtr step,
 		StatementAstNodePtr body
 	)
-		: StatementAstNode{AstNodeType::kFor}
+		: StatementAstNode{kNodeType}
 		, variable{std::move(variable)}
 		, begin{std::move(begin)}
 		, end{std::move(end)}
@@ -441,23 +521,25 @@ public:
 	StatementAstNodePtr body;
 };
 
-using ForAstNodePtr = std::shared_ptr<ForAstNode>;
-using ForAstNodeCPtr = std::shared_ptr<const ForAstNode>;
+using ForAstNodePtr = ForAstNode*;
+using ForAstNodeCPtr = const ForAstNode*;
 
 
 class CallAstNode : public StatementAstNode {
 public:
-	CallAstNode(const SubroutineAstNodePtr& sp, const std::vector<ExpressionAstNodePtr>& as)
-		: StatementAstNode{AstNodeType::kCall}
-		, subroutine_call{std::make_shared<ApplyAstNode>(sp, as)}
+	static constexpr AstNodeType kNodeType = AstNodeType::kCall;
+
+	explicit CallAstNode(ApplyAstNodePtr subroutine_call)
+		: StatementAstNode{kNodeType}
+		, subroutine_call{subroutine_call}
 	{
 	}
 
 	ApplyAstNodePtr subroutine_call;
 };
 
-using CallAstNodePtr = std::shared_ptr<CallAstNode>;
-using CallAstNodeCPtr = std::shared_ptr<const CallAstNode>;
+using CallAstNodePtr = CallAstNode*;
+using CallAstNodeCPtr = const CallAstNode*;
 
 
 /// @brief Подпрограмма
@@ -465,40 +547,140 @@ using CallAstNodeCPtr = std::shared_ptr<const CallAstNode>;
 /// Является функцией, если содержит команду @c LET со своим названием.
 class SubroutineAstNode : public AstNode {
 public:
-	SubroutineAstNode(std::string_view name, std::vector<std::string> parameters)
-		: AstNode{AstNodeType::kSubroutine}
+	static constexpr AstNodeType kNodeType = AstNodeType::kSubroutine;
+
+	SubroutineAstNode(std::string_view name, std::vector<std::string_view> parameters)
+		: AstNode{kNodeType}
 		, name_{name}
 		, parameters_{std::move(parameters)}
 	{
 	}
 
-	[[nodiscard]] const std::string& GetName() const { return name_; }
-	[[nodiscard]] const std::vector<std::string>& GetParameters() const { return parameters_; }
+	[[nodiscard]] std::string_view GetName() const { return name_; }
+	[[nodiscard]] const std::vector<std::string_view>& GetParameters() const { return parameters_; }
 
 	std::vector<VariableAstNodePtr> local_variables;
-	StatementAstNodePtr body;
+	StatementAstNodePtr body = nullptr;
 	bool is_builtin = false;
 	bool is_returning_value = false;
 
+	std::vector<ApplyAstNodePtr> calls;  ///< Вызовы в порядке появления в тексте
+	std::array<std::uint8_t, 16> token_digest{};  ///< MD5 лексем подпрограммы
+
 private:
-	std::string name_;
-	std::vector<std::string> parameters_;
+	std::string_view name_;
+	std::vector<std::string_view> parameters_;
 };
 
 
+/// @brief Программа
+///
+/// Владеет ареной, в которой размещены все остальные узлы дерева,
+/// а также имена и текстовые литералы. Дерево освобождается целиком
+/// вместе с программой.
 class ProgramAstNode : public AstNode {
 public:
+	static constexpr AstNodeType kNodeType = AstNodeType::kProgram;
+
 	explicit ProgramAstNode(std::string_view fn)
-		: AstNode{AstNodeType::kProgram}
+		: AstNode{kNodeType}
 		, filename{fn}
 	{
 	}
 
+	Arena arena;
+
 	std::string filename;
 	std::vector<SubroutineAstNodePtr> subroutines;
 };
 
-using ProgramAstNodePtr = std::shared_ptr<ProgramAstNode>;
-using ProgramAstNodeCPtr = std::shared_ptr<const ProgramAstNode>;
+using ProgramAstNodePtr = ProgramAstNode*;
+using ProgramAstNodeCPtr = const ProgramAstNode*;
+using ProgramAstNodeOwner = std::unique_ptr<ProgramAstNode>;
+
+
+/// Проверяет, что узел имеет тип @p T (по AstNodeType, без RTTI)
+template <typename T>
+bool AstNodeIs(const AstNode* node) {
+	return node != nullptr && node->GetNodeType() == T::kNodeType;
+}
+
+/// Приводит узел к типу @p T или возвращает nullptr, если тип другой
+template <typename T>
+T* AstNodeCast(AstNode* node) {
+	return AstNodeIs<T>(node) ? static_cast<T*>(node) : nullptr;
+}
+
+
+// Статическая диспетчеризация: @p visitor вызывается с узлом, приведённым
+// к его настоящему типу через static_cast по AstNodeType. Для неизвестных
+// типов возвращается значение по умолчанию.
+
+template <typename Visitor>
+auto VisitExpression(ExpressionAstNodePtr node, Visitor&& visitor) -> std::invoke_result_t<Visitor, BooleanAstNodePtr> {
+	switch (node->GetNodeType()) {
+	case AstNodeType::kBoolean: return visitor(static_cast<BooleanAstNodePtr>(node));
+	case AstNodeType::kNumber: return visitor(static_cast<NumberAstNodePtr>(node));
+	case AstNodeType::kText: return visitor(static_cast<TextAstNodePtr>(node));
+	case AstNodeType::kVariable: return visitor(static_cast<VariableAstNodePtr>(node));
+	case AstNodeType::kItem: return visitor(static_cast<ItemAstNodePtr>(node));
+	case AstNodeType::kUnary: return visitor(static_cast<UnaryExpressionAstNodePtr>(node));
+	case AstNodeType::kBinary: return visitor(static_cast<BinaryExpressionAstNodePtr>(node));
+	case AstNodeType::kApply: return visitor(static_cast<ApplyAstNodePtr>(node));
+	default: return std::invoke_result_t<Visitor, BooleanAstNodePtr>();
+	}
+}
+
+template <typename Visitor>
+auto VisitStatement(StatementAstNodePtr node, Visitor&& visitor) -> std::invoke_result_t<Visitor, SequenceAstNodePtr> {
+	switch (node->GetNodeType()) {
+	case AstNodeType::kSequence: return visitor(static_cast<SequenceAstNodePtr>(node));
+	case AstNodeType::kInput: return visitor(static_cast<InputAstNodePtr>(node));
+	case AstNodeType::kPrint: return visitor(static_cast<PrintAstNodePtr>(node));
+	case AstNodeType::kLet: return visitor(static_cast<LetAstNodePtr>(node));
+	case AstNodeType::kDim: return visitor(static_cast<DimAstNodePtr>(node));
+	case AstNodeType::kIf: return visitor(static_cast<IfAstNodePtr>(node));
+	case AstNodeType::kWhile: return visitor(static_cast<WhileAstNodePtr>(node));
+	case AstNodeType::kFor: return visitor(static_cast<ForAstNodePtr>(node));
+	case AstNodeType::kCall: return visitor(static_cast<CallAstNodePtr>(node));
+	default: return std::invoke_result_t<Visitor, SequenceAstNodePtr>();
+	}
+}
+
+template <typename Visitor>
+auto VisitAstNode(AstNodePtr node, Visitor&& visitor) -> std::invoke_result_t<Visitor, ProgramAstNodePtr> {
+	switch (node->GetNodeType()) {
+	case AstNodeType::kBoolean:
+	case AstNodeType::kNumber:
+	case AstNodeType::kText:
+	case AstNodeType::kVariable:
+	case AstNodeType::kItem:
+	case AstNodeType::kUnary:
+	case AstNodeType::kBinary:
+	case AstNodeType::kApply:
+		return VisitExpression(static_cast<ExpressionAstNodePtr>(node), std::forward<Visitor>(visitor));
+	case AstNodeType::kSequence:
+	case AstNodeType::kInput:
+	case AstNodeType::kPrint:
+	case AstNodeType::kLet:
+	case AstNodeType::kDim:
+	case AstNodeType::kIf:
+	case AstNodeType::kWhile:
+	case AstNodeType::kFor:
+	case AstNodeType::kCall:
+		return VisitStatement(static_cast<StatementAstNodePtr>(node), std::forward<Visitor>(visitor));
+	case AstNodeType::kSubroutine: return visitor(static_cast<SubroutineAstNodePtr>(node));
+	case AstNodeType::kProgram: return visitor(static_cast<ProgramAstNodePtr>(node));
+	default: return std::invoke_result_t<Visitor, ProgramAstNodePtr>();
+	}
+}
+
+/// Число узлов дерева каждого типа; индекс — AstNodeType
+using AstNodeCounts = std::array<size_t, static_cast<size_t>(AstNodeType::kProgram) + 1>;
+
+/// @brief Считает узлы дерева программы
+///
+/// Переменная считается один раз, сколько бы выражений на неё ни ссылалось.
+AstNodeCounts CountAstNodes(ProgramAstNodeCPtr program);
 
 }  // namespace bsq
@@ -1,9 +1,13 @@
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
 
 #define BUFFER_SIZE 1024
+#define ARRAY_ALIGNMENT 64
+#define HUGE_PAGE_SIZE (2 * 1024 * 1024)
 
 
 double bsq_number_input(const char* prompt) {
@@ -23,6 +27,110 @@ void bsq_number_print(double value) {
 	printf("%lf\n", value);
 }
 
+long long bsq_integer_input(const char* prompt) {
+	printf("%s ", prompt);
+
+	long long value = 0;
+	scanf("%lld", &value);
+
+	while (getchar() != '\n') {
+		// сожрат!
+	}
+
+	return value;
+}
+
+void bsq_integer_print(long long value) {
+	printf("%lld\n", value);
+}
+
+void bsq_division_by_zero(void) {
+	fputs("Ошибка: целочисленное деление на ноль\n", stderr);
+	exit(EXIT_FAILURE);
+}
+
+void bsq_index_out_of_range(long long index, long long length) {
+	fprintf(stderr, "Ошибка: индекс %lld вне массива длины %lld\n", index, length);
+	exit(EXIT_FAILURE);
+}
+
+static void bsq_array_out_of_memory(void) {
+	fputs("Ошибка: недостаточно памяти для массива\n", stderr);
+	exit(EXIT_FAILURE);
+}
+
+static size_t bsq_array_size(long long count) {
+	size_t size = (size_t)count * sizeof(double);
+	if (size >= HUGE_PAGE_SIZE) {
+		return (size + HUGE_PAGE_SIZE - 1) & ~(size_t)(HUGE_PAGE_SIZE - 1);
+	}
+	return (size + ARRAY_ALIGNMENT - 1) & ~(size_t)(ARRAY_ALIGNMENT - 1);
+}
+
+// массивы от HUGE_PAGE_SIZE отображаются отдельно и по возможности
+// в огромные страницы; память mmap уже заполнена нулями
+__attribute__((noinline, malloc, assume_aligned(ARRAY_ALIGNMENT)))
+double* bsq_array_alloc(long long count) {
+	if ((size_t)count > SIZE_MAX / 2 / sizeof(double)) {
+		bsq_array_out_of_memory();
+	}
+
+	size_t size = bsq_array_size(count);
+	void* result = NULL;
+	if (size >= HUGE_PAGE_SIZE) {
+		result = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (result == MAP_FAILED) {
+			result = NULL;
+		}
+#ifdef MADV_HUGEPAGE
+		else {
+			madvise(result, size, MADV_HUGEPAGE);
+		}
+#endif
+	} else {
+		result = aligned_alloc(ARRAY_ALIGNMENT, size > 0 ? size : ARRAY_ALIGNMENT);
+		if (result != NULL) {
+			memset(result, 0, size);
+		}
+	}
+
+	if (result == NULL) {
+		bsq_array_out_of_memory();
+	}
+	return result;
+}
+
+void bsq_array_free(double* array, long long count) {
+	size_t size = bsq_array_size(count);
+	if (size >= HUGE_PAGE_SIZE) {
+		munmap(array, size);
+	} else {
+		free(array);
+	}
+}
+
+// новые элементы, от length до new_length, заполняются нулями
+double* bsq_array_resize(double* array, long long length, long long capacity, long long new_length, long long new_capacity) {
+	if (new_length < 0) {
+		fputs("Ошибка: отрицательный размер массива\n", stderr);
+		exit(EXIT_FAILURE);
+	}
+
+	if (new_capacity != capacity) {
+		double* result = bsq_array_alloc(new_capacity);
+		if (array != NULL) {
+			memcpy(result, array, (size_t)(length < new_length ? length : new_length) * sizeof(double));
+		}
+		bsq_array_free(array, capacity);
+		return result;
+	}
+
+	if (new_length > length) {
+		memset(array + length, 0, (size_t)(new_length - length) * sizeof(double));
+	}
+	return array;
+}
+
 char* bsq_text_input(const char* prompt) {
 	printf("%s ", prompt);
 
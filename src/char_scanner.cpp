@@ -0,0 +1,172 @@
+#include "char_scanner.hpp"
+
+#include <cstring>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define BSQ_SCANNER_X86 1
+#include <immintrin.h>
+#endif
+
+
+namespace {
+
+using Scanner = const char* (*)(const char*, const char*);
+
+template <bool (*InClass)(char)>
+const char* sSkipScalar(const char* begin, const char* end) {
+	while (begin != end && InClass(*begin)) {
+		++begin;
+	}
+	return begin;
+}
+
+#ifdef BSQ_SCANNER_X86
+
+// Маски символов класса для 16 и 32 байт. Сравнения знаковые, поэтому
+// байты >= 0x80 в диапазоны ASCII не попадают.
+
+__m128i sInRange(__m128i chars, char low, char high) {
+	return _mm_and_si128(
+		_mm_cmpgt_epi8(chars, _mm_set1_epi8(static_cast<char>(low - 1))),
+		_mm_cmpgt_epi8(_mm_set1_epi8(static_cast<char>(high + 1)), chars)
+	);
+}
+
+__m128i sDigitMask(__m128i chars) {
+	return sInRange(chars, '0', '9');
+}
+
+__m128i sAlnumMask(__m128i chars) {
+	const auto lower = _mm_or_si128(chars, _mm_set1_epi8(0x20));
+	return _mm_or_si128(sDigitMask(chars), sInRange(lower, 'a', 'z'));
+}
+
+__m128i sBlankMask(__m128i chars) {
+	return _mm_or_si128(
+		_mm_or_si128(_mm_cmpeq_epi8(chars, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(chars, _mm_set1_epi8('\t'))),
+		_mm_cmpeq_epi8(chars, _mm_set1_epi8('\r'))
+	);
+}
+
+__attribute__((target("avx2"))) __m256i sInRange(__m256i chars, char low, char high) {
+	return _mm256_and_si256(
+		_mm256_cmpgt_epi8(chars, _mm256_set1_epi8(static_cast<char>(low - 1))),
+		_mm256_cmpgt_epi8(_mm256_set1_epi8(static_cast<char>(high + 1)), chars)
+	);
+}
+
+__attribute__((target("avx2"))) __m256i sDigitMask(__m256i chars) {
+	return sInRange(chars, '0', '9');
+}
+
+__attribute__((target("avx2"))) __m256i sAlnumMask(__m256i chars) {
+	const auto lower = _mm256_or_si256(chars, _mm256_set1_epi8(0x20));
+	return _mm256_or_si256(sDigitMask(chars), sInRange(lower, 'a', 'z'));
+}
+
+__attribute__((target("avx2"))) __m256i sBlankMask(__m256i chars) {
+	return _mm256_or_si256(
+		_mm256_or_si256(
+			_mm256_cmpeq_epi8(chars, _mm256_set1_epi8(' ')),
+			_mm256_cmpeq_epi8(chars, _mm256_set1_epi8('\t'))
+		),
+		_mm256_cmpeq_epi8(chars, _mm256_set1_epi8('\r'))
+	);
+}
+
+template <__m128i (*Mask)(__m128i), bool (*InClass)(char)>
+const char* sSkipSse2(const char* begin, const char* end) {
+	while (end - begin >= 16) {
+		const auto chars = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin));
+		const auto outside = ~static_cast<unsigned>(_mm_movemask_epi8(Mask(chars))) & 0xFFFFu;
+		if (outside != 0) {
+			return begin + __builtin_ctz(outside);
+		}
+		begin += 16;
+	}
+	return sSkipScalar<InClass>(begin, end);
+}
+
+template <__m256i (*Mask)(__m256i), bool (*InClass)(char)>
+__attribute__((target("avx2"))) const char* sSkipAvx2(const char* begin, const char* end) {
+	while (end - begin >= 32) {
+		const auto chars = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(begin));
+		const auto outside = ~static_cast<unsigned>(_mm256_movemask_epi8(Mask(chars)));
+		if (outside != 0) {
+			return begin + __builtin_ctz(outside);
+		}
+		begin += 32;
+	}
+	return sSkipScalar<InClass>(begin, end);
+}
+
+#endif  // BSQ_SCANNER_X86
+
+struct Scanners {
+	Scanner alnums;
+	Scanner digits;
+	Scanner blanks;
+};
+
+const Scanners& sSelectScanners() {
+	static const Scanners scanners = [] {
+#ifdef BSQ_SCANNER_X86
+		if (__builtin_cpu_supports("avx2")) {
+			return Scanners{
+				sSkipAvx2<sAlnumMask, bsq::IsAlnum>,
+				sSkipAvx2<sDigitMask, bsq::IsDigit>,
+				sSkipAvx2<sBlankMask, bsq::IsBlank>,
+			};
+		}
+		return Scanners{
+			sSkipSse2<sAlnumMask, bsq::IsAlnum>,
+			sSkipSse2<sDigitMask, bsq::IsDigit>,
+			sSkipSse2<sBlankMask, bsq::IsBlank>,
+		};
+#else
+		return Scanners{
+			sSkipScalar<bsq::IsAlnum>,
+			sSkipScalar<bsq::IsDigit>,
+			sSkipScalar<bsq::IsBlank>,
+		};
+#endif
+	}();
+	return scanners;
+}
+
+}  // namespace
+
+
+namespace bsq {
+
+// Идентификаторы, числа и отступы обычно короче одного вектора,
+// поэтому первые символы проверяются без векторных загрузок.
+
+const char* SkipAlnums(const char* begin, const char* end) {
+	if (begin == end || !IsAlnum(*begin)) {
+		return begin;
+	}
+	return sSelectScanners().alnums(begin, end);
+}
+
+const char* SkipDigits(const char* begin, const char* end) {
+	if (begin == end || !IsDigit(*begin)) {
+		return begin;
+	}
+	return sSelectScanners().digits(begin, end);
+}
+
+const char* SkipBlanks(const char* begin, const char* end) {
+	if (begin == end || !IsBlank(*begin)) {
+		return begin;
+	}
+	return sSelectScanners().blanks(begin, end);
+}
+
+const char* SkipLine(const char* begin, const char* end) {
+	// memchr в libc уже векторизован под текущий процессор
+	const auto* new_line = static_cast<const char*>(std::memchr(begin, '\n', static_cast<size_t>(end - begin)));
+	return new_line != nullptr ? new_line : end;
+}
+
+}  // namespace bsq
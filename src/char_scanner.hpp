@@ -0,0 +1,26 @@
+#pragma once
+
+
+namespace bsq {
+
+// Классы символов лексического анализатора. В отличие от std::isdigit
+// и std::isalpha не зависят от локали: учитываются только символы ASCII.
+
+[[nodiscard]] constexpr bool IsDigit(char c) { return c >= '0' && c <= '9'; }
+[[nodiscard]] constexpr bool IsAlpha(char c) { return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z'); }
+[[nodiscard]] constexpr bool IsAlnum(char c) { return IsDigit(c) || IsAlpha(c); }
+[[nodiscard]] constexpr bool IsBlank(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+
+// Поиск конца серии символов одного класса в [begin, end).
+// Возвращают указатель на первый символ вне класса или end.
+// Реализация (AVX2, SSE2 или скалярная) выбирается при первом вызове
+// по возможностям процессора.
+
+const char* SkipAlnums(const char* begin, const char* end);
+const char* SkipDigits(const char* begin, const char* end);
+const char* SkipBlanks(const char* begin, const char* end);
+
+/// Конец однострочного комментария: первый '\n' или end
+const char* SkipLine(const char* begin, const char* end);
+
+}  // namespace bsq
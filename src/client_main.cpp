@@ -0,0 +1,17 @@
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "server.hpp"
+
+
+/// bsq-client СОКЕТ [аргументы bsq] — то же, что bsq --connect СОКЕТ,
+/// но без LLVM: процесс запускается быстрее, чем компилятор
+int main(int argc, char* argv[]) {
+	if (argc < 2) {
+		std::cerr << "Использование: " << argv[0] << " СОКЕТ [аргументы bsq]" << std::endl;
+		return 1;
+	}
+
+	return bsq::CompileOnServer(argv[1], std::vector<std::string>(argv + 2, argv + argc));
+}
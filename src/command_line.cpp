@@ -0,0 +1,133 @@
+#include "command_line.hpp"
+
+#include <charconv>
+#include <fstream>
+#include <string_view>
+#include <system_error>
+
+#include <llvm/Support/ThreadPool.h>
+
+#include "trace.hpp"
+
+
+namespace {
+
+using namespace bsq;
+
+/// Дописывает к @p sources файлы из файла-списка @p list, по одному в строке
+bool sReadResponseFile(const std::filesystem::path& list, std::vector<std::filesystem::path>& sources, std::ostream& errors) {
+	std::ifstream in{list};
+	if (!in) {
+		errors << list.string() << ": не удалось открыть список файлов" << std::endl;
+		return false;
+	}
+
+	for (std::string line; std::getline(in, line);) {
+		if (!line.empty()) {
+			sources.emplace_back(line);
+		}
+	}
+	return true;
+}
+
+/// Уровень оптимизации из -O0, -O1, -O2, -O3 или -Os
+std::optional<OptimizationLevel> sParseOptimizationLevel(std::string_view argument) {
+	if (argument == "-O0") {
+		return OptimizationLevel::kO0;
+	}
+	if (argument == "-O1") {
+		return OptimizationLevel::kO1;
+	}
+	if (argument == "-O2") {
+		return OptimizationLevel::kO2;
+	}
+	if (argument == "-O3") {
+		return OptimizationLevel::kO3;
+	}
+	if (argument == "-Os") {
+		return OptimizationLevel::kOs;
+	}
+	return std::nullopt;
+}
+
+/// Компилирует файлы командной строки
+int sRun(const CommandLine& command_line, CompilerPool& compilers, std::ostream& out, std::ostream& errors) {
+	// --jobs N file1.bas file2.bas ... или @список
+	if (command_line.is_batch || command_line.sources.size() > 1) {
+		return CompileBatch(command_line.sources, command_line.jobs, command_line.options, compilers, out, errors) ? 0 : 1;
+	}
+
+	const std::filesystem::path source = command_line.sources.empty() ? "../tests/bubble.bas" : command_line.sources.front();
+
+	llvm::ThreadPool pool;  // потоки создаются при первой задаче
+	auto options = command_line.options;
+	options.thread_pool = &pool;
+
+	auto compiler = compilers.Acquire();
+	const bool is_compiled = compiler->Compile(source, options, out, errors);
+	compilers.Release(std::move(compiler));
+
+	out << is_compiled << std::endl;
+	return 0;
+}
+
+}  // namespace
+
+
+namespace bsq {
+
+std::optional<CommandLine> ParseCommandLine(const std::vector<std::string>& arguments, std::ostream& errors) {
+	CommandLine command_line;
+	for (size_t i = 0; i < arguments.size(); ++i) {
+		const std::string_view argument = arguments[i];
+		const bool has_value = i + 1 < arguments.size();
+		if (const auto level = sParseOptimizationLevel(argument); level.has_value()) {
+			command_line.options.optimization_level = *level;
+		} else if (argument == "--parallel-codegen") {
+			command_line.options.is_parallel_codegen = true;
+		} else if (argument == "--bounds-check") {
+			command_line.options.is_bounds_checking = true;
+		} else if (argument == "--time-report") {
+			command_line.options.time_report = TimeReportFormat::kText;
+		} else if (argument == "--time-report=json") {
+			command_line.options.time_report = TimeReportFormat::kJson;
+		} else if (argument == "--trace" && has_value) {
+			command_line.trace_file = arguments[++i];
+		} else if (argument == "--cache-dir" && has_value) {
+			command_line.options.cache_directory = arguments[++i];
+		} else if (argument == "--jobs" && has_value) {
+			const std::string_view jobs = arguments[++i];
+			if (std::from_chars(jobs.data(), jobs.data() + jobs.size(), command_line.jobs).ec != std::errc{}) {
+				errors << "--jobs: ожидается число потоков, а не " << jobs << std::endl;
+				return std::nullopt;
+			}
+			command_line.is_batch = true;
+		} else if (argument == "--serve" && has_value) {
+			command_line.serve_socket = arguments[++i];
+		} else if (argument == "--connect" && has_value) {
+			command_line.server_socket = arguments[++i];
+		} else if (argument.starts_with('@')) {
+			if (!sReadResponseFile(argument.substr(1), command_line.sources, errors)) {
+				return std::nullopt;
+			}
+			command_line.is_batch = true;
+		} else {
+			command_line.sources.emplace_back(argument);
+		}
+	}
+	return command_line;
+}
+
+int RunCommandLine(const CommandLine& command_line, CompilerPool& compilers, std::ostream& out, std::ostream& errors) {
+	if (!command_line.trace_file.has_value()) {
+		return sRun(command_line, compilers, out, errors);
+	}
+
+	if (!StartTrace(errors)) {
+		return 1;
+	}
+	const int status = sRun(command_line, compilers, out, errors);
+	return FinishTrace(*command_line.trace_file, errors) ? status : 1;
+}
+
+}  // namespace bsq
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "compiler.hpp"
+
+
+namespace bsq {
+
+/// Разобранные аргументы командной строки
+struct CommandLine {
+	CompileOptions options;
+	std::vector<std::filesystem::path> sources;
+
+	/// Пакетный режим: задан --jobs или файл-список @список
+	bool is_batch = false;
+	size_t jobs = 0;  ///< 0 — по числу ядер
+
+	/// --trace ФАЙЛ: записать трассировку компиляции, см. trace.hpp
+	std::optional<std::filesystem::path> trace_file;
+
+	/// --serve СОКЕТ: работать сервером компиляции, см. Serve
+	std::optional<std::filesystem::path> serve_socket;
+	/// --connect СОКЕТ: передать запрос серверу, см. CompileOnServer
+	std::optional<std::filesystem::path> server_socket;
+};
+
+/// Разбирает @p arguments (без имени программы); ошибки выводятся в @p errors
+std::optional<CommandLine> ParseCommandLine(const std::vector<std::string>& arguments, std::ostream& errors = std::cerr);
+
+/// @brief Компилирует файлы командной строки Compiler из @p compilers
+///
+/// Возвращает код завершения процесса.
+int RunCommandLine(const CommandLine& command_line, CompilerPool& compilers, std::ostream& out = std::cout, std::ostream& errors = std::cerr);
+
+}  // namespace bsq
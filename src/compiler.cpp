@@ -1,44 +1,201 @@
 #include "compiler.hpp"
 
-#include <iostream>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <system_error>
+#include <utility>
 
-#include <llvm/AsmParser/Parser.h>
+#include <llvm/Bitcode/BitcodeReader.h>
 #include <llvm/IR/IRPrintingPasses.h>
 #include <llvm/IR/LegacyPassManager.h>
 #include <llvm/IR/Verifier.h>
 #include <llvm/Linker/Linker.h>
+#include <llvm/MC/TargetRegistry.h>
 #include <llvm/Pass.h>
+#include <llvm/Passes/PassBuilder.h>
 #include <llvm/Support/FileSystem.h>
 #include <llvm/Support/raw_ostream.h>
-#include <llvm/Support/SourceMgr.h>
+#include <llvm/Support/TargetSelect.h>
+#include <llvm/Support/ThreadPool.h>
+#include <llvm/Target/TargetMachine.h>
+#include <llvm/Transforms/IPO/Internalize.h>
+#include <llvm/Transforms/Scalar/ConstraintElimination.h>
+#include <llvm/Transforms/Scalar/InductiveRangeCheckElimination.h>
 
 #include "ast.hpp"
+#include "constant_folder.hpp"
 #include "ir_generator.hpp"
+#include "library_bitcode.hpp"
 #include "semantic_checker.hpp"
+#include "subroutine_cache.hpp"
 #include "syntax_parser.hpp"
+#include "time_report.hpp"
+#include "trace.hpp"
 
 
 namespace {
 
 using namespace bsq;
 
-std::unique_ptr<llvm::Module> sCompileBasicIr(llvm::LLVMContext& context, const std::filesystem::path& source) {
+/// @brief Сколько файлов Compiler компилирует в одном LLVMContext
+///
+/// Типы, константы, строки и метаданные всех модулей остаются в контексте
+/// до его разрушения, и память сервера или длинного пакета росла бы
+/// без предела. Новый контекст дешёв: библиотека и так читается заново.
+constexpr size_t kCompilesPerContext = 64;
+
+/// Метка компилятора для ключей кэша: размер и время изменения
+/// исполняемого файла меняются при каждой пересборке
+std::string sCompilerStamp(const std::filesystem::path& self_path) {
+	std::error_code ec;
+	const auto size = std::filesystem::file_size(self_path, ec);
+	const auto time = std::filesystem::last_write_time(self_path, ec);
+	return "bsq " + std::to_string(size) + " " + std::to_string(time.time_since_epoch().count());
+}
+
+llvm::MemoryBufferRef sLibraryBitcode() {
+	const llvm::StringRef bitcode{reinterpret_cast<const char*>(kLibraryBitcode), kLibraryBitcodeSize};
+	return llvm::MemoryBufferRef{bitcode, "bsq_lib.bc"};
+}
+
+/// @brief Библиотека времени выполнения, встроенная в компилятор
+///
+/// Модуль ленивый: тела функций читаются из bitcode, только когда их
+/// затребует связывание с LinkOnlyNeeded, поэтому загрузка для каждого
+/// файла дешевле, чем полный разбор и копия. nullptr при ошибке чтения.
+std::unique_ptr<llvm::Module> sLoadLibrary(llvm::LLVMContext& context) {
+	auto library = llvm::getLazyBitcodeModule(sLibraryBitcode(), context);
+	if (!library) {
+		llvm::consumeError(library.takeError());
+		return nullptr;
+	}
+	return std::move(*library);
+}
+
+/// @brief Машина целевой платформы @p triple
+///
+/// Без неё конвейер оптимизации не знает стоимости инструкций и ширины
+/// векторных регистров и, например, не векторизует циклы. nullptr,
+/// если платформа не поддерживается.
+std::unique_ptr<llvm::TargetMachine> sCreateTargetMachine(const std::string& triple) {
+	static const bool is_initialized = !llvm::InitializeNativeTarget();
+	if (!is_initialized) {
+		return nullptr;
+	}
+
+	std::string error;
+	const auto* target = llvm::TargetRegistry::lookupTarget(triple, error);
+	if (target == nullptr) {
+		return nullptr;
+	}
+	return std::unique_ptr<llvm::TargetMachine>{target->createTargetMachine(triple, "generic", "", {}, llvm::None)};
+}
+
+llvm::OptimizationLevel sToLlvm(OptimizationLevel level) {
+	switch (level) {
+	case OptimizationLevel::kO1: return llvm::OptimizationLevel::O1;
+	case OptimizationLevel::kO2: return llvm::OptimizationLevel::O2;
+	case OptimizationLevel::kO3: return llvm::OptimizationLevel::O3;
+	case OptimizationLevel::kOs: return llvm::OptimizationLevel::Os;
+	default: return llvm::OptimizationLevel::O0;
+	}
+}
+
+/// @brief Оптимизирует связанный модуль стандартным конвейером LLVM
+///
+/// Всё, кроме точки входа main, становится внутренним для модуля:
+/// подпрограммы и функции библиотеки, вызванные один раз или короткие,
+/// встраиваются в места вызова, а остальные без вызовов удаляются.
+///
+/// С проверкой индексов конвейер дополняется ConstraintElimination,
+/// которая удаляет проверки, следующие из условий циклов и ветвлений,
+/// и IRCE, которая делит цикл так, что основная часть итераций идёт
+/// без проверок. Обе работают до векторизации.
+void sOptimize(llvm::Module& module, OptimizationLevel level, bool is_bounds_checking, llvm::TargetMachine* target_machine) {
+	llvm::LoopAnalysisManager loop_analyses;
+	llvm::FunctionAnalysisManager function_analyses;
+	llvm::CGSCCAnalysisManager cgscc_analyses;
+	llvm::ModuleAnalysisManager module_analyses;
+
+	llvm::PassBuilder builder{target_machine};
+	builder.registerModuleAnalyses(module_analyses);
+	builder.registerCGSCCAnalyses(cgscc_analyses);
+	builder.registerFunctionAnalyses(function_analyses);
+	builder.registerLoopAnalyses(loop_analyses);
+	builder.crossRegisterProxies(loop_analyses, function_analyses, cgscc_analyses, module_analyses);
+
+	if (is_bounds_checking) {
+		builder.registerScalarOptimizerLateEPCallback([](llvm::FunctionPassManager& function_passes, llvm::OptimizationLevel) {
+			function_passes.addPass(llvm::ConstraintEliminationPass());
+			function_passes.addPass(llvm::IRCEPass());
+		});
+	}
+
+	llvm::ModulePassManager passes;
+	passes.addPass(llvm::VerifierPass());
+	passes.addPass(llvm::InternalizePass([](const llvm::GlobalValue& value) { return value.getName() == "main"; }));
+	passes.addPass(builder.buildPerModuleDefaultPipeline(sToLlvm(level)));
+	passes.run(module, module_analyses);
+}
+
+std::unique_ptr<llvm::Module> sCompileBasicIr(llvm::LLVMContext& context, const std::filesystem::path& source, const CompileOptions& options, SubroutineCache* cache, TimeReport* report, std::ostream& out, std::ostream& errors) {
 	if (!std::filesystem::exists(source)) {
 		return nullptr;
 	}
 
-	ProgramAstNodePtr program = SyntaxParser(source).Parse();
+	ProgramAstNodeOwner program;
+	{
+		TimeReport::Scope scope{report, TimeReport::Phase::kParse};
+		program = SyntaxParser(source, errors).Parse(options.thread_pool);
+	}
 	if (!program) {
 		return nullptr;
 	}
 
-	if (const auto check = SemanticChecker().Check(program); check.has_value()) {
-		std::cout << check.value() << std::endl;
-		return nullptr;
+	if (report != nullptr) {
+		report->SetAstNodeCounts(CountAstNodes(program.get()));
+	}
+
+	{
+		TimeReport::Scope scope{report, TimeReport::Phase::kCheck};
+		if (const auto check = SemanticChecker().Check(program.get()); check.has_value()) {
+			out << check.value() << std::endl;
+			return nullptr;
+		}
 	}
 
+	{
+		TimeReport::Scope scope{report, TimeReport::Phase::kFold};
+		ConstantFolder().Fold(program.get());
+	}
+
+	TimeReport::Scope scope{report, TimeReport::Phase::kEmit};
+
 	auto module = std::make_unique<llvm::Module>(source.string(), context);
-	if (!IrGenerator(context, *module.get()).Emit(program)) {
+	IrGenerator generator(context, *module.get(), options.is_bounds_checking);
+
+	auto* pool = options.thread_pool;
+	const bool is_parallel = options.is_parallel_codegen
+		&& pool != nullptr
+		&& pool->getThreadCount() > 1
+		&& program->subroutines.size() > 1;
+
+	bool is_emitted = false;
+	if (cache != nullptr) {
+		is_emitted = generator.Emit(program.get(), *cache, is_parallel ? pool : nullptr);
+	} else if (is_parallel) {
+		is_emitted = generator.Emit(program.get(), *pool);
+	} else {
+		is_emitted = generator.Emit(program.get());
+	}
+
+	if (!is_emitted) {
 		return nullptr;
 	}
 	return module;
@@ -49,43 +206,207 @@ std::unique_ptr<llvm::Module> sCompileBasicIr(llvm::LLVMContext& context, const
 
 namespace bsq {
 
-bool Compile(const std::filesystem::path& source) {
-	const std::filesystem::path self_path = llvm::sys::fs::getMainExecutable(nullptr, nullptr);
-	const auto library_path = self_path.parent_path() / "bsq_lib.ll";
+Compiler::Compiler()
+	: stamp_{sCompilerStamp(llvm::sys::fs::getMainExecutable(nullptr, nullptr))}
+	, context_{std::make_unique<llvm::LLVMContext>()}
+{
+	// платформа читается из заголовка bitcode, сама библиотека — при
+	// компиляции каждого файла, см. sLoadLibrary
+	auto triple = llvm::getBitcodeTargetTriple(sLibraryBitcode());
+	if (!triple) {
+		llvm::consumeError(triple.takeError());
+		return;
+	}
+	target_machine_ = sCreateTargetMachine(*triple);
+}
 
-	llvm::LLVMContext context;
+Compiler::~Compiler() = default;
 
-	llvm::SMDiagnostic smd;
-	auto library_module = llvm::parseAssemblyFile(library_path.string(), smd, context);
-	if (!library_module) {
+bool Compiler::Compile(const std::filesystem::path& source, const CompileOptions& options, std::ostream& out, std::ostream& errors) {
+	TRACE_DETAIL(Compile, source.string());
+
+	if (!options.time_report.has_value()) {
+		return Compile_(source, options, nullptr, out, errors);
+	}
+
+	TimeReport report{source};
+	const bool is_compiled = Compile_(source, options, &report, out, errors);
+	report.Print(out, *options.time_report, is_compiled);
+	return is_compiled;
+}
+
+bool Compiler::Compile_(const std::filesystem::path& source, const CompileOptions& options, TimeReport* report, std::ostream& out, std::ostream& errors) {
+	if (++compile_count_ % kCompilesPerContext == 0) {
+		context_ = std::make_unique<llvm::LLVMContext>();
+	}
+
+	auto library = sLoadLibrary(*context_);
+	if (!library) {
 		return false;
 	}
 
-	auto program_module = sCompileBasicIr(context, source);
+	std::optional<SubroutineCache> cache;
+	if (options.cache_directory.has_value()) {
+		cache.emplace(*options.cache_directory, options.is_bounds_checking ? stamp_ + " bounds-check" : stamp_);
+	}
+
+	auto program_module = sCompileBasicIr(*context_, source, options, cache ? &*cache : nullptr, report, out, errors);
+
+	if (cache.has_value()) {
+		const auto& statistics = cache->GetStatistics();
+		out << "Кэш подпрограмм: попаданий " << statistics.hits << ", промахов " << statistics.misses << std::endl;
+	}
+
 	if (!program_module) {
 		return false;
 	}
 
 	auto ir_module_all = source;
 	ir_module_all.replace_extension("ll");
-	auto linked_module = std::make_unique<llvm::Module>(ir_module_all.string(), context);
+	auto linked_module = std::make_unique<llvm::Module>(ir_module_all.string(), *context_);
+
+	{
+		TRACE(LinkProgram);
+		TimeReport::Scope scope{report, TimeReport::Phase::kLinkProgram};
+		llvm::Linker::linkModules(*linked_module, std::move(program_module));
+	}
+	{
+		TRACE(LinkLibrary);
+		TimeReport::Scope scope{report, TimeReport::Phase::kLinkLibrary};
+		llvm::Linker::linkModules(*linked_module, std::move(library), llvm::Linker::Flags::LinkOnlyNeeded);
+	}
+
+	if (options.optimization_level != OptimizationLevel::kO0) {
+		TRACE(Optimize);
+		TimeReport::Scope scope{report, TimeReport::Phase::kOptimize};
+		sOptimize(*linked_module, options.optimization_level, options.is_bounds_checking, target_machine_.get());
+	}
+
+	if (report != nullptr) {
+		report->SetModuleStatistics(*linked_module);
+	}
 
-	llvm::Linker::linkModules(*linked_module, std::move(program_module));
-	llvm::Linker::linkModules(*linked_module, std::move(library_module));
+	TRACE(Print);
+	TimeReport::Scope scope{report, TimeReport::Phase::kPrint};
 
 	std::error_code ec;
-	llvm::raw_fd_ostream out(ir_module_all.string(), ec, llvm::sys::fs::OF_None);
+	llvm::raw_fd_ostream ir_out(ir_module_all.string(), ec, llvm::sys::fs::OF_None);
 	if (ec) {
-		std::cout << ec.value() << ": " << ec.message() << std::endl;
+		out << ec.value() << ": " << ec.message() << std::endl;
 		return false;
 	}
 
 	llvm::legacy::PassManager pm;
 	pm.add(llvm::createVerifierPass());
-	pm.add(llvm::createPrintModulePass(out, ""));
+	pm.add(llvm::createPrintModulePass(ir_out, ""));
 	pm.run(*linked_module.get());
 
 	return true;
 }
 
+std::unique_ptr<Compiler> CompilerPool::Acquire() {
+	{
+		std::lock_guard lock{mutex_};
+		if (!idle_.empty()) {
+			auto compiler = std::move(idle_.back());
+			idle_.pop_back();
+			return compiler;
+		}
+	}
+	return std::make_unique<Compiler>();
+}
+
+void CompilerPool::Release(std::unique_ptr<Compiler> compiler) {
+	std::lock_guard lock{mutex_};
+	idle_.push_back(std::move(compiler));
+}
+
+bool Compile(const std::filesystem::path& source, const CompileOptions& options) {
+	return Compiler{}.Compile(source, options);
+}
+
+bool CompileBatch(const std::vector<std::filesystem::path>& sources, size_t jobs, const CompileOptions& options, CompilerPool& compilers, std::ostream& out, std::ostream& errors) {
+	struct Result {
+		std::string out;
+		std::string errors;
+		bool is_compiled = false;
+		bool is_done = false;
+	};
+	std::vector<Result> results(sources.size());
+	std::mutex mutex;
+	std::condition_variable done;
+
+	// Каждый поток берёт следующий файл, пока они не кончатся,
+	// и компилирует их одним Compiler из compilers. Потоки пакета уже
+	// заняли ядра, поэтому сам файл компилируется в одном потоке
+	auto file_options = options;
+	file_options.thread_pool = nullptr;
+
+	llvm::ThreadPool pool{llvm::hardware_concurrency(static_cast<unsigned>(jobs))};
+	const auto worker_count = std::min(sources.size(), static_cast<size_t>(pool.getThreadCount()));
+	std::atomic<size_t> next = 0;
+	for (size_t i = 0; i < worker_count; ++i) {
+		pool.async([&] {
+			TraceThread trace_thread;
+
+			// исключение вне задачи пропало бы в её future, а файлы потока
+			// остались бы неготовыми, и вывод ждал бы их вечно
+			std::unique_ptr<Compiler> compiler;
+			std::string acquire_error;
+			try {
+				compiler = compilers.Acquire();
+			}
+			catch (const std::exception& e) {
+				acquire_error = e.what();
+			}
+
+			for (size_t j = next++; j < sources.size(); j = next++) {
+				std::ostringstream file_out;
+				std::ostringstream file_errors;
+				bool is_compiled = false;
+				try {
+					if (compiler) {
+						is_compiled = compiler->Compile(sources[j], file_options, file_out, file_errors);
+					} else {
+						file_errors << "не удалось создать компилятор: " << acquire_error << std::endl;
+					}
+				}
+				catch (const std::exception& e) {
+					file_errors << e.what() << std::endl;
+				}
+
+				std::lock_guard lock{mutex};
+				results[j] = Result{file_out.str(), file_errors.str(), is_compiled, true};
+				done.notify_one();
+			}
+			if (compiler) {
+				compilers.Release(std::move(compiler));
+			}
+		});
+	}
+
+	// сообщения выводятся по порядку, как только готов очередной файл
+	size_t compiled_count = 0;
+	for (size_t i = 0; i < sources.size(); ++i) {
+		Result result;
+		{
+			std::unique_lock lock{mutex};
+			done.wait(lock, [&] { return results[i].is_done; });
+			result = std::move(results[i]);
+		}
+
+		out << result.out << std::flush;
+		errors << result.errors << std::flush;
+		if (result.is_compiled) {
+			++compiled_count;
+		} else {
+			errors << sources[i].string() << ": не скомпилирован" << std::endl;
+		}
+	}
+	pool.wait();
+
+	out << "Скомпилировано файлов: " << compiled_count << " из " << sources.size() << std::endl;
+	return compiled_count == sources.size();
+}
+
 }  // namespace bsq
@@ -1,10 +1,115 @@
 #pragma once
 
+#include <cstddef>
 #include <filesystem>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "time_report.hpp"
+
+
+namespace llvm {
+
+class LLVMContext;
+class TargetMachine;
+class ThreadPool;
+
+}  // namespace llvm
 
 
 namespace bsq {
 
-bool Compile(const std::filesystem::path& source);
+/// Уровень оптимизации связанного модуля (-O0 ... -O3, -Os)
+enum class OptimizationLevel {
+	kO0,
+	kO1,
+	kO2,
+	kO3,
+	kOs,
+};
+
+struct CompileOptions {
+	/// Конвейер оптимизации LLVM, которым обрабатывается программа
+	/// вместе с библиотекой времени выполнения
+	OptimizationLevel optimization_level = OptimizationLevel::kO2;
+
+	/// Генерировать IR подпрограмм параллельно потоками thread_pool,
+	/// см. IrGenerator::Emit
+	bool is_parallel_codegen = false;
+
+	/// @brief Потоки для разбора файла и для is_parallel_codegen,
+	/// см. SyntaxParser::Parse
+	///
+	/// Один пул на процесс: файлы пакета, см. CompileBatch, компилируются
+	/// каждый в своём потоке без него. nullptr — в вызывающем потоке.
+	llvm::ThreadPool* thread_pool = nullptr;
+
+	/// Проверять индексы массивов при выполнении, см. IrGenerator::EmitElement_
+	bool is_bounds_checking = false;
+
+	/// Каталог кэша IR подпрограмм, см. SubroutineCache
+	std::optional<std::filesystem::path> cache_directory;
+
+	/// Выводить после компиляции отчёт о времени и памяти, см. TimeReport
+	std::optional<TimeReportFormat> time_report;
+};
+
+/// @brief Компилятор нескольких файлов подряд
+///
+/// Машина целевой платформы создаётся один раз и служит всем
+/// компилируемым файлам, LLVMContext — нескольким файлам подряд,
+/// а библиотека времени выполнения лениво читается из встроенного
+/// bitcode для каждого файла. Объект не потокобезопасен:
+/// при параллельной компиляции у каждого потока свой Compiler.
+class Compiler {
+public:
+	Compiler();
+	~Compiler();
+
+	Compiler(const Compiler&) = delete;
+	Compiler& operator=(const Compiler&) = delete;
+
+	/// Компилирует @p source в source.ll; сообщения выводятся в @p out,
+	/// сообщения об ошибках разбора — в @p errors
+	bool Compile(const std::filesystem::path& source, const CompileOptions& options = {}, std::ostream& out = std::cout, std::ostream& errors = std::cerr);
+
+private:
+	bool Compile_(const std::filesystem::path& source, const CompileOptions& options, TimeReport* report, std::ostream& out, std::ostream& errors);
+
+private:
+	std::string stamp_;  ///< Метка компилятора для ключей кэша
+
+	std::unique_ptr<llvm::LLVMContext> context_;  ///< Заменяется новым раз в несколько файлов, см. Compile_
+	size_t compile_count_ = 0;  ///< Файлы, скомпилированные этим объектом
+	std::unique_ptr<llvm::TargetMachine> target_machine_;  ///< Платформа библиотеки для оптимизации; может быть nullptr
+};
+
+/// @brief Готовые к работе Compiler, которые потоки берут и возвращают
+///
+/// Позволяет не создавать Compiler заново для каждого пакета файлов.
+/// Потокобезопасен.
+class CompilerPool {
+public:
+	/// Свободный Compiler или новый, если свободных нет
+	std::unique_ptr<Compiler> Acquire();
+	void Release(std::unique_ptr<Compiler> compiler);
+
+private:
+	std::mutex mutex_;
+	std::vector<std::unique_ptr<Compiler>> idle_;
+};
+
+bool Compile(const std::filesystem::path& source, const CompileOptions& options = {});
+
+/// @brief Компилирует файлы @p sources потоками, не более @p jobs (0 — по числу ядер)
+///
+/// Потоки берут Compiler из @p compilers. Сообщения о каждом файле
+/// собираются и выводятся в порядке @p sources. Возвращает true,
+/// если скомпилированы все файлы.
+bool CompileBatch(const std::vector<std::filesystem::path>& sources, size_t jobs, const CompileOptions& options, CompilerPool& compilers, std::ostream& out = std::cout, std::ostream& errors = std::cerr);
 
 }  // namespace bsq
@@ -0,0 +1,377 @@
+#include "constant_folder.hpp"
+
+#include <cmath>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "trace.hpp"
+
+
+namespace {
+
+using namespace bsq;
+
+bool sIsConstant(ExpressionAstNodeCPtr expression) {
+	const auto type = expression->GetNodeType();
+	return type == AstNodeType::kNumber || type == AstNodeType::kBoolean || type == AstNodeType::kText;
+}
+
+std::optional<double> sFoldArithmetic(Operation operation, double lhs, double rhs) {
+	switch (operation) {
+	case Operation::kAdd: return lhs + rhs;
+	case Operation::kSub: return lhs - rhs;
+	case Operation::kMul: return lhs * rhs;
+	case Operation::kDiv: return lhs / rhs;
+	case Operation::kMod: return std::fmod(lhs, rhs);
+	case Operation::kPow: return std::pow(lhs, rhs);
+	default: return std::nullopt;
+	}
+}
+
+/// @brief Операция над целыми так же, как в IrGenerator
+///
+/// Переполнение — по модулю 2^64. Деление на ноль, которое проверяется
+/// при выполнении, не сворачивается.
+std::optional<std::int64_t> sFoldIntegerArithmetic(Operation operation, std::int64_t lhs, std::int64_t rhs) {
+	const auto a = static_cast<std::uint64_t>(lhs);
+	const auto b = static_cast<std::uint64_t>(rhs);
+	switch (operation) {
+	case Operation::kAdd: return static_cast<std::int64_t>(a + b);
+	case Operation::kSub: return static_cast<std::int64_t>(a - b);
+	case Operation::kMul: return static_cast<std::int64_t>(a * b);
+	case Operation::kIntDiv:
+		if (rhs == 0) {
+			return std::nullopt;
+		}
+		return rhs == -1 ? static_cast<std::int64_t>(0 - a) : lhs / rhs;
+	case Operation::kMod:
+		if (rhs == 0) {
+			return std::nullopt;
+		}
+		return rhs == -1 ? 0 : lhs % rhs;
+	default: return std::nullopt;
+	}
+}
+
+/// Сравнение чисел так же, как fcmp и icmp в IrGenerator: с NaN всё ложно
+template <typename T>
+std::optional<bool> sFoldComparison(Operation operation, T lhs, T rhs) {
+	switch (operation) {
+	case Operation::kEq: return lhs == rhs;
+	case Operation::kNe: return lhs < rhs || lhs > rhs;
+	case Operation::kGt: return lhs > rhs;
+	case Operation::kGe: return lhs >= rhs;
+	case Operation::kLt: return lhs < rhs;
+	case Operation::kLe: return lhs <= rhs;
+	default: return std::nullopt;
+	}
+}
+
+/// Сравнение текстов так же, как strcmp в bsq_text_eq и других
+std::optional<bool> sFoldComparison(Operation operation, std::string_view lhs, std::string_view rhs) {
+	const int order = lhs.compare(rhs);
+	switch (operation) {
+	case Operation::kEq: return order == 0;
+	case Operation::kNe: return order != 0;
+	case Operation::kGt: return order > 0;
+	case Operation::kGe: return order >= 0;
+	case Operation::kLt: return order < 0;
+	case Operation::kLe: return order <= 0;
+	default: return std::nullopt;
+	}
+}
+
+std::optional<bool> sFoldLogical(Operation operation, bool lhs, bool rhs) {
+	switch (operation) {
+	case Operation::kAnd: return lhs && rhs;
+	case Operation::kOr: return lhs || rhs;
+	case Operation::kEq: return lhs == rhs;
+	case Operation::kNe: return lhs != rhs;
+	default: return std::nullopt;
+	}
+}
+
+}  // namespace
+
+
+namespace bsq {
+
+void ConstantFolder::Fold(ProgramAstNodePtr program) {
+	TRACE(Fold);
+
+	program_ = program;
+	for (const auto& subroutine : program->subroutines) {
+		Fold_(subroutine);
+	}
+}
+
+void ConstantFolder::Fold_(SubroutineAstNodePtr subroutine) {
+	if (subroutine->body == nullptr) {
+		return;
+	}
+
+	constants_.clear();
+	subroutine->body = Fold_(subroutine->body);
+}
+
+StatementAstNodePtr ConstantFolder::Fold_(StatementAstNodePtr statement) {
+	return VisitStatement(statement, [this](auto node) { return Fold_(node); });
+}
+
+StatementAstNodePtr ConstantFolder::Fold_(SequenceAstNodePtr sequence) {
+	for (auto& statement : sequence->items) {
+		statement = Fold_(statement);
+	}
+
+	// удалённые IF и WHILE оставляют пустые последовательности
+	std::erase_if(sequence->items, [](StatementAstNodePtr statement) {
+		const auto* nested = AstNodeCast<SequenceAstNode>(statement);
+		return nested != nullptr && nested->items.empty();
+	});
+	return sequence;
+}
+
+StatementAstNodePtr ConstantFolder::Fold_(LetAstNodePtr let) {
+	let->expression = Fold_(let->expression);
+	if (let->array_index != nullptr) {
+		let->array_index = Fold_(let->array_index);
+	}
+
+	if (let->variable->OfType(DataType::kArray)) {
+		return let;
+	}
+
+	if (sIsConstant(let->expression)) {
+		constants_[let->variable->GetName()] = let->expression;
+	} else {
+		constants_.erase(let->variable->GetName());
+	}
+	return let;
+}
+
+StatementAstNodePtr ConstantFolder::Fold_(DimAstNodePtr dim) {
+	dim->size = Fold_(dim->size);
+	return dim;
+}
+
+StatementAstNodePtr ConstantFolder::Fold_(InputAstNodePtr input) {
+	if (input->item != nullptr) {
+		input->item->expression = Fold_(input->item->expression);
+	} else {
+		constants_.erase(input->variable->GetName());
+	}
+	return input;
+}
+
+StatementAstNodePtr ConstantFolder::Fold_(PrintAstNodePtr print) {
+	print->expression = Fold_(print->expression);
+	return print;
+}
+
+StatementAstNodePtr ConstantFolder::Fold_(IfAstNodePtr if_node) {
+	if_node->condition = Fold_(if_node->condition);
+
+	// IF с постоянным условием заменяется выполняемой ветвью; ELSEIF —
+	// это IF в ветви otherwise, и он сворачивается так же
+	if (const auto* condition = AstNodeCast<BooleanAstNode>(if_node->condition)) {
+		if (condition->GetValue()) {
+			return Fold_(if_node->then);
+		}
+		return if_node->otherwise != nullptr ? Fold_(if_node->otherwise) : MakeEmptyStatement_();
+	}
+
+	if_node->then = FoldBranch_(if_node->then);
+	if (if_node->otherwise != nullptr) {
+		if_node->otherwise = FoldBranch_(if_node->otherwise);
+	}
+	Forget_(if_node);
+	return if_node;
+}
+
+StatementAstNodePtr ConstantFolder::Fold_(WhileAstNodePtr while_node) {
+	// значения, которые меняет тело, неизвестны уже при первой проверке условия
+	Forget_(while_node->body);
+
+	while_node->condition = Fold_(while_node->condition);
+	if (const auto* condition = AstNodeCast<BooleanAstNode>(while_node->condition); condition && !condition->GetValue()) {
+		return MakeEmptyStatement_();
+	}
+
+	while_node->body = FoldBranch_(while_node->body);
+	return while_node;
+}
+
+StatementAstNodePtr ConstantFolder::Fold_(ForAstNodePtr for_node) {
+	for_node->begin = Fold_(for_node->begin);
+	for_node->end = Fold_(for_node->end);
+
+	constants_.erase(for_node->variable->GetName());
+	Forget_(for_node->body);
+
+	for_node->body = FoldBranch_(for_node->body);
+	return for_node;
+}
+
+StatementAstNodePtr ConstantFolder::Fold_(CallAstNodePtr call) {
+	Fold_(call->subroutine_call);
+	return call;
+}
+
+ExpressionAstNodePtr ConstantFolder::Fold_(ExpressionAstNodePtr expression) {
+	return VisitExpression(expression, [this](auto node) { return Fold_(node); });
+}
+
+ExpressionAstNodePtr ConstantFolder::Fold_(ApplyAstNodePtr apply) {
+	// подпрограммы не меняют переменных вызывающей подпрограммы
+	for (size_t i = 0; i < apply->GetArguments().size(); ++i) {
+		apply->SetArgument(i, Fold_(apply->GetArguments()[i]));
+	}
+	return apply;
+}
+
+ExpressionAstNodePtr ConstantFolder::Fold_(BinaryExpressionAstNodePtr binary) {
+	binary->SetLeftOperand(Fold_(binary->GetLeftOperand()));
+	binary->SetRightOperand(Fold_(binary->GetRightOperand()));
+
+	auto& arena = program_->arena;
+	const auto operation = binary->GetOperation();
+	auto* lhs = binary->GetLeftOperand();
+	auto* rhs = binary->GetRightOperand();
+
+	if (lhs->GetNodeType() != rhs->GetNodeType()) {
+		return binary;
+	}
+
+	if (const auto* number = AstNodeCast<NumberAstNode>(lhs)) {
+		const auto lhs_value = number->GetValue();
+		const auto rhs_value = static_cast<NumberAstNodePtr>(rhs)->GetValue();
+		if (number->OfType(DataType::kInteger)) {
+			const auto lhs_integer = number->GetIntegerValue();
+			const auto rhs_integer = static_cast<NumberAstNodePtr>(rhs)->GetIntegerValue();
+			if (const auto value = sFoldIntegerArithmetic(operation, lhs_integer, rhs_integer)) {
+				return MakeInteger_(*value);
+			}
+			if (const auto value = sFoldComparison(operation, lhs_integer, rhs_integer)) {
+				return MakeAstNode<BooleanAstNode>(arena, *value);
+			}
+		}
+		if (binary->OfType(DataType::kInteger)) {
+			return binary;  // деление на ноль
+		}
+		if (const auto value = sFoldArithmetic(operation, lhs_value, rhs_value)) {
+			return MakeAstNode<NumberAstNode>(arena, *value);
+		}
+		if (const auto value = sFoldComparison(operation, lhs_value, rhs_value)) {
+			return MakeAstNode<BooleanAstNode>(arena, *value);
+		}
+	} else if (const auto* boolean = AstNodeCast<BooleanAstNode>(lhs)) {
+		const auto rhs_value = static_cast<BooleanAstNodePtr>(rhs)->GetValue();
+		if (const auto value = sFoldLogical(operation, boolean->GetValue(), rhs_value)) {
+			return MakeAstNode<BooleanAstNode>(arena, *value);
+		}
+	} else if (const auto* text = AstNodeCast<TextAstNode>(lhs)) {
+		const auto rhs_value = static_cast<TextAstNodePtr>(rhs)->GetValue();
+		if (Operation::kConc == operation) {
+			const auto value = std::string{text->GetValue()} + std::string{rhs_value};
+			return MakeAstNode<TextAstNode>(arena, arena.Intern(value));
+		}
+		if (const auto value = sFoldComparison(operation, text->GetValue(), rhs_value)) {
+			return MakeAstNode<BooleanAstNode>(arena, *value);
+		}
+	}
+
+	return binary;
+}
+
+ExpressionAstNodePtr ConstantFolder::Fold_(UnaryExpressionAstNodePtr unary) {
+	unary->SetOperand(Fold_(unary->GetOperand()));
+
+	auto& arena = program_->arena;
+	if (const auto* number = AstNodeCast<NumberAstNode>(unary->GetOperand()); number && Operation::kSub == unary->GetOperation()) {
+		if (number->OfType(DataType::kInteger)) {
+			return MakeInteger_(static_cast<std::int64_t>(0 - static_cast<std::uint64_t>(number->GetIntegerValue())));
+		}
+		return MakeAstNode<NumberAstNode>(arena, -number->GetValue());
+	}
+	if (const auto* boolean = AstNodeCast<BooleanAstNode>(unary->GetOperand()); boolean && Operation::kNot == unary->GetOperation()) {
+		return MakeAstNode<BooleanAstNode>(arena, !boolean->GetValue());
+	}
+	return unary;
+}
+
+ExpressionAstNodePtr ConstantFolder::Fold_(TextAstNodePtr text) {
+	return text;
+}
+
+ExpressionAstNodePtr ConstantFolder::Fold_(NumberAstNodePtr number) {
+	return number;
+}
+
+ExpressionAstNodePtr ConstantFolder::Fold_(BooleanAstNodePtr boolean) {
+	return boolean;
+}
+
+ExpressionAstNodePtr ConstantFolder::Fold_(VariableAstNodePtr variable) {
+	if (const auto it = constants_.find(variable->GetName()); it != constants_.end()) {
+		return it->second;
+	}
+	return variable;
+}
+
+ExpressionAstNodePtr ConstantFolder::Fold_(ItemAstNodePtr item) {
+	item->expression = Fold_(item->expression);
+	return item;
+}
+
+StatementAstNodePtr ConstantFolder::FoldBranch_(StatementAstNodePtr statement) {
+	auto constants = constants_;
+	auto* folded = Fold_(statement);
+	constants_ = std::move(constants);
+	return folded;
+}
+
+void ConstantFolder::Forget_(StatementAstNodePtr statement) {
+	Assignments assignments;
+	CollectAssignments_(statement, assignments);
+	for (const auto& name : assignments) {
+		constants_.erase(name);
+	}
+}
+
+void ConstantFolder::CollectAssignments_(StatementAstNodePtr statement, Assignments& assignments) {
+	if (statement == nullptr) {
+		return;
+	}
+
+	if (auto* sequence = AstNodeCast<SequenceAstNode>(statement)) {
+		for (auto* item : sequence->items) {
+			CollectAssignments_(item, assignments);
+		}
+	} else if (auto* let = AstNodeCast<LetAstNode>(statement)) {
+		assignments.insert(let->variable->GetName());
+	} else if (auto* input = AstNodeCast<InputAstNode>(statement); input && input->item == nullptr) {
+		assignments.insert(input->variable->GetName());
+	} else if (auto* if_node = AstNodeCast<IfAstNode>(statement)) {
+		CollectAssignments_(if_node->then, assignments);
+		CollectAssignments_(if_node->otherwise, assignments);
+	} else if (auto* while_node = AstNodeCast<WhileAstNode>(statement)) {
+		CollectAssignments_(while_node->body, assignments);
+	} else if (auto* for_node = AstNodeCast<ForAstNode>(statement)) {
+		assignments.insert(for_node->variable->GetName());
+		CollectAssignments_(for_node->body, assignments);
+	}
+}
+
+StatementAstNodePtr ConstantFolder::MakeEmptyStatement_() {
+	return MakeAstNode<SequenceAstNode>(program_->arena);
+}
+
+ExpressionAstNodePtr ConstantFolder::MakeInteger_(std::int64_t value) {
+	auto* integer = MakeAstNode<NumberAstNode>(program_->arena, static_cast<double>(value), value);
+	integer->SetType(DataType::kInteger);
+	return integer;
+}
+
+}  // namespace bsq
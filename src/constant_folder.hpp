@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "ast.hpp"
+
+
+namespace bsq {
+
+/// @brief Свёртка констант в дереве программы
+///
+/// Выполняется после SemanticChecker, перед IrGenerator. Вычисляет
+/// числовые, логические и текстовые выражения из литералов, подставляет
+/// значения переменных, которым присвоены константы, и удаляет ветви IF
+/// и циклы WHILE с постоянным условием. Новые узлы размещаются в арене
+/// программы. Вызовы подпрограмм не вычисляются.
+class ConstantFolder {
+public:
+	void Fold(ProgramAstNodePtr program);
+
+private:
+	/// Имена переменных, которым присваивается значение
+	using Assignments = std::unordered_set<std::string_view>;
+
+	void Fold_(SubroutineAstNodePtr subroutine);
+
+	/// Возвращает оператор, которым нужно заменить @p statement
+	StatementAstNodePtr Fold_(StatementAstNodePtr statement);
+	StatementAstNodePtr Fold_(SequenceAstNodePtr sequence);
+	StatementAstNodePtr Fold_(LetAstNodePtr let);
+	StatementAstNodePtr Fold_(DimAstNodePtr dim);
+	StatementAstNodePtr Fold_(InputAstNodePtr input);
+	StatementAstNodePtr Fold_(PrintAstNodePtr print);
+	StatementAstNodePtr Fold_(IfAstNodePtr if_node);
+	StatementAstNodePtr Fold_(WhileAstNodePtr while_node);
+	StatementAstNodePtr Fold_(ForAstNodePtr for_node);
+	StatementAstNodePtr Fold_(CallAstNodePtr call);
+
+	/// Возвращает выражение, которым нужно заменить @p expression
+	ExpressionAstNodePtr Fold_(ExpressionAstNodePtr expression);
+	ExpressionAstNodePtr Fold_(ApplyAstNodePtr apply);
+	ExpressionAstNodePtr Fold_(BinaryExpressionAstNodePtr binary);
+	ExpressionAstNodePtr Fold_(UnaryExpressionAstNodePtr unary);
+	ExpressionAstNodePtr Fold_(TextAstNodePtr text);
+	ExpressionAstNodePtr Fold_(NumberAstNodePtr number);
+	ExpressionAstNodePtr Fold_(BooleanAstNodePtr boolean);
+	ExpressionAstNodePtr Fold_(VariableAstNodePtr variable);
+	ExpressionAstNodePtr Fold_(ItemAstNodePtr item);
+
+	/// Свёртка ветви: известные значения переменных после неё не сохраняются
+	StatementAstNodePtr FoldBranch_(StatementAstNodePtr statement);
+	/// Забывает значения переменных, которым присваивается в @p statement
+	void Forget_(StatementAstNodePtr statement);
+
+	static void CollectAssignments_(StatementAstNodePtr statement, Assignments& assignments);
+
+	StatementAstNodePtr MakeEmptyStatement_();
+	/// Литерал типа INTEGER
+	ExpressionAstNodePtr MakeInteger_(std::int64_t value);
+
+private:
+	ProgramAstNodePtr program_ = nullptr;
+
+	/// Переменные, значение которых в текущей точке известно
+	std::unordered_map<std::string_view, ExpressionAstNodePtr> constants_;
+};
+
+}  // namespace bsq
@@ -0,0 +1,314 @@
+#include "integer_inference.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+
+namespace {
+
+using namespace bsq;
+
+/// Наибольший по модулю шаг целочисленного счётчика FOR
+constexpr double kStepLimit = 4294967296.0;  // 2^32
+/// Сколько раз промежуток переменной может расшириться, прежде чем она
+/// будет признана нецелочисленной: присваивания вроде LET k = k + 1
+/// расширяют его на каждой итерации
+constexpr int kMaxWidenings = 8;
+
+bool sIsExact(double value) {
+	return std::trunc(value) == value && std::fabs(value) <= IntegerInference::kExactLimit;
+}
+
+/// Присваивается ли переменной @p name значение в @p statement
+bool sIsAssigned(StatementAstNodePtr statement, std::string_view name) {
+	if (statement == nullptr) {
+		return false;
+	}
+
+	if (auto* sequence = AstNodeCast<SequenceAstNode>(statement)) {
+		return std::any_of(sequence->items.begin(), sequence->items.end(), [name](auto* item) { return sIsAssigned(item, name); });
+	}
+	if (auto* let = AstNodeCast<LetAstNode>(statement)) {
+		return let->variable->GetName() == name;
+	}
+	if (auto* input = AstNodeCast<InputAstNode>(statement)) {
+		return input->item == nullptr && input->variable->GetName() == name;
+	}
+	if (auto* if_node = AstNodeCast<IfAstNode>(statement)) {
+		return sIsAssigned(if_node->then, name) || sIsAssigned(if_node->otherwise, name);
+	}
+	if (auto* while_node = AstNodeCast<WhileAstNode>(statement)) {
+		return sIsAssigned(while_node->body, name);
+	}
+	if (auto* for_node = AstNodeCast<ForAstNode>(statement)) {
+		return for_node->variable->GetName() == name || sIsAssigned(for_node->body, name);
+	}
+	return false;
+}
+
+}  // namespace
+
+
+namespace bsq {
+
+IntegerInference::IntegerInference(SubroutineAstNodePtr subroutine) {
+	for (const auto& variable : subroutine->local_variables) {
+		if (variable->OfType(DataType::kNumeric)) {
+			variables_[variable->GetName()] = Range{};
+		}
+	}
+	for (const auto& parameter : subroutine->GetParameters()) {
+		variables_.erase(parameter);
+	}
+
+	if (subroutine->body == nullptr) {
+		return;
+	}
+
+	CollectAssignments_(subroutine->body);
+	Infer_();
+	RecordExpressions_(subroutine->body);
+}
+
+bool IntegerInference::IsIntegral(std::string_view variable) const {
+	const auto it = variables_.find(variable);
+	return it != variables_.end() && it->second.has_value();
+}
+
+bool IntegerInference::IsIntegral(ExpressionAstNodePtr expression) const {
+	return expressions_.contains(expression);
+}
+
+bool IntegerInference::IsIntegralValue(ExpressionAstNodePtr expression) const {
+	const auto it = expressions_.find(expression);
+	return it != expressions_.end() && !it->second.may_be_negative_zero;
+}
+
+bool IntegerInference::IsWithin(ExpressionAstNodePtr expression, double lo, double hi) const {
+	const auto it = expressions_.find(expression);
+	return it != expressions_.end() && it->second.lo >= lo && it->second.hi <= hi;
+}
+
+void IntegerInference::CollectAssignments_(StatementAstNodePtr statement) {
+	if (statement == nullptr) {
+		return;
+	}
+
+	if (auto* sequence = AstNodeCast<SequenceAstNode>(statement)) {
+		for (auto* item : sequence->items) {
+			CollectAssignments_(item);
+		}
+	} else if (auto* let = AstNodeCast<LetAstNode>(statement)) {
+		assignments_.emplace_back(let->variable->GetName(), let);
+	} else if (auto* input = AstNodeCast<InputAstNode>(statement); input && input->item == nullptr) {
+		variables_.erase(input->variable->GetName());
+	} else if (auto* if_node = AstNodeCast<IfAstNode>(statement)) {
+		CollectAssignments_(if_node->then);
+		CollectAssignments_(if_node->otherwise);
+	} else if (auto* while_node = AstNodeCast<WhileAstNode>(statement)) {
+		CollectAssignments_(while_node->body);
+	} else if (auto* for_node = AstNodeCast<ForAstNode>(statement)) {
+		// промежуток счётчика, который меняет тело цикла, не вычисляется
+		if (sIsAssigned(for_node->body, for_node->variable->GetName())) {
+			variables_.erase(for_node->variable->GetName());
+		}
+		assignments_.emplace_back(for_node->variable->GetName(), for_node);
+		CollectAssignments_(for_node->body);
+	}
+}
+
+void IntegerInference::Infer_() {
+	// промежутки только расширяются, а переменная, признанная
+	// нецелочисленной, такой и остаётся, поэтому итерации сходятся
+	std::unordered_map<std::string_view, int> widenings;
+	for (bool is_changed = true; is_changed;) {
+		is_changed = false;
+		for (const auto& assignment : assignments_) {
+			const auto it = variables_.find(assignment.first);
+			if (it == variables_.end() || !it->second) {
+				continue;
+			}
+
+			auto& range = *it->second;
+			const auto value = Evaluate_(assignment);
+			if (!value || value->may_be_negative_zero) {
+				it->second.reset();
+				is_changed = true;
+				continue;
+			}
+
+			if (value->lo < range.lo || value->hi > range.hi) {
+				range.lo = std::min(range.lo, value->lo);
+				range.hi = std::max(range.hi, value->hi);
+				if (++widenings[assignment.first] > kMaxWidenings) {
+					it->second.reset();
+				}
+				is_changed = true;
+			}
+		}
+	}
+}
+
+void IntegerInference::RecordExpressions_(StatementAstNodePtr statement) {
+	if (statement == nullptr) {
+		return;
+	}
+
+	if (auto* sequence = AstNodeCast<SequenceAstNode>(statement)) {
+		for (auto* item : sequence->items) {
+			RecordExpressions_(item);
+		}
+	} else if (auto* let = AstNodeCast<LetAstNode>(statement)) {
+		RecordExpression_(let->expression);
+		if (let->array_index != nullptr) {
+			RecordExpression_(let->array_index);
+		}
+	} else if (auto* dim = AstNodeCast<DimAstNode>(statement)) {
+		RecordExpression_(dim->size);
+	} else if (auto* input = AstNodeCast<InputAstNode>(statement)) {
+		if (input->item != nullptr) {
+			RecordExpression_(input->item);
+		}
+	} else if (auto* print = AstNodeCast<PrintAstNode>(statement)) {
+		RecordExpression_(print->expression);
+	} else if (auto* if_node = AstNodeCast<IfAstNode>(statement)) {
+		RecordExpression_(if_node->condition);
+		RecordExpressions_(if_node->then);
+		RecordExpressions_(if_node->otherwise);
+	} else if (auto* while_node = AstNodeCast<WhileAstNode>(statement)) {
+		RecordExpression_(while_node->condition);
+		RecordExpressions_(while_node->body);
+	} else if (auto* for_node = AstNodeCast<ForAstNode>(statement)) {
+		RecordExpression_(for_node->begin);
+		RecordExpression_(for_node->end);
+		RecordExpressions_(for_node->body);
+	} else if (auto* call = AstNodeCast<CallAstNode>(statement)) {
+		RecordExpression_(call->subroutine_call);
+	}
+}
+
+void IntegerInference::RecordExpression_(ExpressionAstNodePtr expression) {
+	if (const auto range = Evaluate_(expression)) {
+		expressions_[expression] = *range;
+	}
+
+	if (auto* unary = AstNodeCast<UnaryExpressionAstNode>(expression)) {
+		RecordExpression_(unary->GetOperand());
+	} else if (auto* binary = AstNodeCast<BinaryExpressionAstNode>(expression)) {
+		RecordExpression_(binary->GetLeftOperand());
+		RecordExpression_(binary->GetRightOperand());
+	} else if (auto* item = AstNodeCast<ItemAstNode>(expression)) {
+		RecordExpression_(item->expression);
+	} else if (auto* apply = AstNodeCast<ApplyAstNode>(expression)) {
+		for (auto* argument : apply->GetArguments()) {
+			RecordExpression_(argument);
+		}
+	}
+}
+
+std::optional<IntegerInference::Range> IntegerInference::Evaluate_(ExpressionAstNodePtr expression) const {
+	if (expression->NotOfType(DataType::kNumeric)) {
+		return std::nullopt;
+	}
+
+	if (const auto* number = AstNodeCast<NumberAstNode>(expression)) {
+		const auto value = number->GetValue();
+		if (!sIsExact(value) || (value == 0.0 && std::signbit(value))) {
+			return std::nullopt;
+		}
+		return Range{value, value, false};
+	}
+
+	if (const auto* variable = AstNodeCast<VariableAstNode>(expression)) {
+		if (const auto it = variables_.find(variable->GetName()); it != variables_.end()) {
+			return it->second;
+		}
+		return std::nullopt;
+	}
+
+	if (auto* unary = AstNodeCast<UnaryExpressionAstNode>(expression)) {
+		const auto operand = Evaluate_(unary->GetOperand());
+		if (Operation::kSub != unary->GetOperation() || !operand) {
+			return std::nullopt;
+		}
+		// -(0) в double равно -0.0
+		return Range{-operand->hi, -operand->lo, operand->lo <= 0.0 && operand->hi >= 0.0};
+	}
+
+	if (auto* binary = AstNodeCast<BinaryExpressionAstNode>(expression)) {
+		return Evaluate_(binary);
+	}
+
+	return std::nullopt;
+}
+
+std::optional<IntegerInference::Range> IntegerInference::Evaluate_(BinaryExpressionAstNodePtr binary) const {
+	const auto lhs = Evaluate_(binary->GetLeftOperand());
+	const auto rhs = Evaluate_(binary->GetRightOperand());
+	if (!lhs || !rhs) {
+		return std::nullopt;
+	}
+
+	const auto contains_zero = [](const Range& range) { return range.lo <= 0.0 && range.hi >= 0.0; };
+
+	// -0.0 получается так же, как в IEEE 754: -0 + -0, -0 - (+0),
+	// произведение нуля на отрицательное, остаток отрицательного делимого
+	Range range;
+	switch (binary->GetOperation()) {
+	case Operation::kAdd:
+		range = {lhs->lo + rhs->lo, lhs->hi + rhs->hi, lhs->may_be_negative_zero && rhs->may_be_negative_zero};
+		break;
+	case Operation::kSub:
+		range = {lhs->lo - rhs->hi, lhs->hi - rhs->lo, lhs->may_be_negative_zero && contains_zero(*rhs)};
+		break;
+	case Operation::kMul: {
+		const auto products = {lhs->lo * rhs->lo, lhs->lo * rhs->hi, lhs->hi * rhs->lo, lhs->hi * rhs->hi};
+		range = {std::min(products), std::max(products),
+			lhs->may_be_negative_zero || rhs->may_be_negative_zero
+				|| ((contains_zero(*lhs) || contains_zero(*rhs)) && (lhs->lo < 0.0 || rhs->lo < 0.0))};
+		break;
+	}
+	case Operation::kMod: {
+		// остаток целых в double совпадает с srem, если делитель не ноль
+		if (contains_zero(*rhs)) {
+			return std::nullopt;
+		}
+		const auto divisor = std::max(std::fabs(rhs->lo), std::fabs(rhs->hi)) - 1.0;
+		range = {lhs->lo < 0.0 ? -divisor : 0.0, lhs->hi > 0.0 ? divisor : 0.0, lhs->may_be_negative_zero || lhs->lo < 0.0};
+		break;
+	}
+	default:
+		return std::nullopt;
+	}
+
+	if (std::fabs(range.lo) > kExactLimit || std::fabs(range.hi) > kExactLimit) {
+		return std::nullopt;
+	}
+	return range;
+}
+
+std::optional<IntegerInference::Range> IntegerInference::Evaluate_(const Assignment& assignment) const {
+	if (auto* let = AstNodeCast<LetAstNode>(assignment.second)) {
+		return Evaluate_(let->expression);
+	}
+
+	// счётчик FOR пробегает значения от начала с целым шагом, пока не
+	// перейдёт границу; нецелая граница ограничивается ±kLoopLimit
+	auto* for_node = static_cast<ForAstNodePtr>(assignment.second);
+	const auto begin = Evaluate_(for_node->begin);
+	const auto step = for_node->step->GetValue();
+	if (!begin || begin->may_be_negative_zero || !sIsExact(step) || step == 0.0 || std::fabs(step) > kStepLimit) {
+		return std::nullopt;
+	}
+
+	const auto end = Evaluate_(for_node->end);
+	auto range = *begin;
+	if (step > 0.0) {
+		range.hi = std::max(range.hi, (end ? end->hi : kLoopLimit) - 1.0 + step);
+	} else {
+		range.lo = std::min(range.lo, (end ? end->lo : -kLoopLimit) + 1.0 + step);
+	}
+	return range;
+}
+
+}  // namespace bsq
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <optional>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "ast.hpp"
+
+
+namespace bsq {
+
+/// @brief Вывод целочисленности числовых переменных и выражений подпрограммы
+///
+/// Для каждой числовой переменной вычисляется промежуток её значений
+/// по всем присваиваниям. Переменная целочисленна, если все её значения —
+/// целые в пределах ±2^53, где double представляет их точно, и ни одно
+/// не может быть -0.0. Тогда IrGenerator хранит её в i64, и результат
+/// совпадает с вычислением в double. Счётчик FOR целочислен при целых
+/// начале и шаге; граница цикла при этом может быть любой, см. kLoopLimit.
+///
+/// Параметры и переменные INPUT не целочисленны: их значения неизвестны.
+class IntegerInference {
+public:
+	/// Целые, которые double представляет точно
+	static constexpr double kExactLimit = 9007199254740992.0;  // 2^53
+
+	/// @brief Наибольшее по модулю значение нецелой границы FOR
+	///
+	/// Граница приводится к целому и ограничивается этим значением; цикл,
+	/// которому это мешает, в double выполнялся бы больше 2^52 итераций.
+	static constexpr double kLoopLimit = 4503599627370496.0;  // 2^52
+
+	explicit IntegerInference(SubroutineAstNodePtr subroutine);
+
+	/// Переменная хранится в i64
+	[[nodiscard]] bool IsIntegral(std::string_view variable) const;
+	/// Выражение точно вычисляется в i64; результат может быть -0.0 в double
+	[[nodiscard]] bool IsIntegral(ExpressionAstNodePtr expression) const;
+	/// Выражение точно вычисляется в i64, и sitofp результата равен значению в double
+	[[nodiscard]] bool IsIntegralValue(ExpressionAstNodePtr expression) const;
+	/// Выражение целочисленно, и все его значения лежат в [@p lo, @p hi]
+	[[nodiscard]] bool IsWithin(ExpressionAstNodePtr expression, double lo, double hi) const;
+
+private:
+	/// Промежуток целых значений
+	struct Range {
+		double lo = 0.0;
+		double hi = 0.0;
+		bool may_be_negative_zero = false;
+	};
+
+	/// Присваивание переменной: LET или заголовок FOR
+	using Assignment = std::pair<std::string_view, StatementAstNodePtr>;
+
+	void CollectAssignments_(StatementAstNodePtr statement);
+	void Infer_();
+	void RecordExpressions_(StatementAstNodePtr statement);
+	void RecordExpression_(ExpressionAstNodePtr expression);
+
+	[[nodiscard]] std::optional<Range> Evaluate_(ExpressionAstNodePtr expression) const;
+	[[nodiscard]] std::optional<Range> Evaluate_(BinaryExpressionAstNodePtr binary) const;
+	[[nodiscard]] std::optional<Range> Evaluate_(const Assignment& assignment) const;
+
+private:
+	/// Кандидаты в целочисленные; nullopt — переменная не целочисленна
+	std::unordered_map<std::string_view, std::optional<Range>> variables_;
+	std::vector<Assignment> assignments_;
+	std::unordered_map<ExpressionAstNodePtr, Range> expressions_;
+};
+
+}  // namespace bsq
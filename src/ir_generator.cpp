@@ -1,60 +1,99 @@
 #include "ir_generator.hpp"
 
-#include <iostream>
+#include <algorithm>
+#include <cstdint>
 #include <list>
+#include <map>
+#include <optional>
+#include <ostream>
+#include <stdexcept>
 #include <system_error>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
 
+#include <llvm/ADT/STLExtras.h>
 #include <llvm/ADT/SmallVector.h>
+#include <llvm/Bitcode/BitcodeReader.h>
+#include <llvm/Bitcode/BitcodeWriter.h>
 #include <llvm/IR/BasicBlock.h>
+#include <llvm/IR/CFG.h>
 #include <llvm/IR/Constant.h>
 #include <llvm/IR/Constants.h>
 #include <llvm/IR/Function.h>
 #include <llvm/IR/GlobalValue.h>
+#include <llvm/IR/GlobalVariable.h>
 #include <llvm/IR/InstrTypes.h>
 #include <llvm/IR/Instructions.h>
+#include <llvm/IR/Intrinsics.h>
+#include <llvm/IR/MDBuilder.h>
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/Metadata.h>
 #include <llvm/IR/Module.h>
 #include <llvm/IR/Type.h>
 #include <llvm/IR/Value.h>
+#include <llvm/IR/ValueHandle.h>
 #include <llvm/IR/Verifier.h>
+#include <llvm/Linker/IRMover.h>
 #include <llvm/Support/Casting.h>
+#include <llvm/Support/Error.h>
+#include <llvm/Support/MemoryBufferRef.h>
+#include <llvm/Support/ThreadPool.h>
+#include <llvm/Support/raw_ostream.h>
 
 #include "ast.hpp"
+#include "trace.hpp"
 
 
 namespace {
 
-class Tracer {
-public:
-	explicit Tracer(std::string_view text) {
-		indent_ += 2;
-		std::cout << std::string(indent_, ' ') << "Emit_(" << text << ")" << std::endl;
-	}
+/// Подпрограммы раздаются потокам пакетами; пакетов больше, чем потоков,
+/// чтобы крупные подпрограммы не задерживали остальные потоки
+constexpr size_t kBatchesPerThread = 4;
+
+/// Наибольший размер массива на стеке: больший массив в рекурсивной
+/// подпрограмме быстро исчерпал бы стек
+constexpr size_t kStackArrayLimit = 16 * 1024;
+/// Выравнивание массивов по строке кэша
+constexpr uint64_t kArrayAlignment = 64;
+/// Вес ветви ошибки времени выполнения относительно продолжения: по нему
+/// оптимизатор выносит ветвь из горячего пути, а IRCE находит проверки
+/// индексов, которые стоит убрать из цикла
+constexpr uint32_t kErrorBranchWeight = 1;
+constexpr uint32_t kContinueBranchWeight = 1 << 20;
+
+bool sIsHeapArray(bsq::VariableAstNodePtr array) {
+	return array->array_size > kStackArrayLimit / sizeof(double);
+}
 
-	~Tracer() {
-		indent_ -= 2;
+std::optional<llvm::CmpInst::Predicate> sIntegerPredicate(bsq::Operation operation) {
+	switch (operation) {
+	case bsq::Operation::kEq: return llvm::CmpInst::ICMP_EQ;
+	case bsq::Operation::kNe: return llvm::CmpInst::ICMP_NE;
+	case bsq::Operation::kGt: return llvm::CmpInst::ICMP_SGT;
+	case bsq::Operation::kGe: return llvm::CmpInst::ICMP_SGE;
+	case bsq::Operation::kLt: return llvm::CmpInst::ICMP_SLT;
+	case bsq::Operation::kLe: return llvm::CmpInst::ICMP_SLE;
+	default: return std::nullopt;
 	}
-
-private:
-	static inline size_t indent_ = 0;
-};
-
-#define TRACE(t) Tracer _t((#t))
-//#define TRACE(t) (void)(#t)
+}
 
 }  // namespace
 
 
 namespace bsq {
 
-IrGenerator::IrGenerator(llvm::LLVMContext& context, llvm::Module& module)
+IrGenerator::IrGenerator(llvm::LLVMContext& context, llvm::Module& module, bool is_bounds_checking)
 	: context_{context}
 	, ir_builder_{context_}
 	, module_{module}
+	, is_bounds_checking_{is_bounds_checking}
 {
 	PrepareLibrary_();
 }
 
 bool IrGenerator::Emit(ProgramAstNodePtr program) {
+	TRACE(Emit);
 	try {
 		Emit_(program);
 		llvm::verifyModule(module_);
@@ -66,9 +105,109 @@ bool IrGenerator::Emit(ProgramAstNodePtr program) {
 	return true;
 }
 
-void IrGenerator::Emit_(ProgramAstNodePtr program) {
-	TRACE(Program);
+bool IrGenerator::Emit(ProgramAstNodePtr program, llvm::ThreadPool& pool) {
+	TRACE(Emit);
+	try {
+		const auto& subroutines = program->subroutines;
+		const auto thread_count = static_cast<size_t>(pool.getThreadCount());
+		const auto batch_count = std::min(subroutines.size(), thread_count * kBatchesPerThread);
+
+		std::vector<Batch> batches(batch_count);
+		for (size_t i = 0; i < batch_count; ++i) {
+			auto& batch = batches[i];
+			batch.first = subroutines.size() * i / batch_count;
+			batch.last = subroutines.size() * (i + 1) / batch_count;
+			pool.async([this, program, &batch] {
+				TraceThread trace_thread;
+				EmitBatches_(program, {&batch}, is_bounds_checking_);
+			});
+		}
+		pool.wait();
+
+		if (!LinkBatches_(program, batches)) {
+			return false;
+		}
+		llvm::verifyModule(module_);
+	}
+	catch (...) {
+		return false;
+	}
+
+	return true;
+}
+
+bool IrGenerator::Emit(ProgramAstNodePtr program, SubroutineCache& cache, llvm::ThreadPool* pool) {
+	TRACE(Emit);
+	try {
+		// каждая подпрограмма — отдельный пакет
+		std::vector<Batch> batches;
+		std::vector<std::string> keys;
+		const auto& subroutines = program->subroutines;
+		for (size_t i = 0; i < subroutines.size(); ++i) {
+			if (subroutines[i]->is_builtin) {
+				continue;
+			}
+
+			auto& batch = batches.emplace_back();
+			batch.first = i;
+			batch.last = i + 1;
+
+			auto& key = keys.emplace_back(cache.GetKey(subroutines[i]));
+			if (auto bitcode = cache.Load(key)) {
+				batch.bitcode = std::move(*bitcode);
+				batch.is_emitted = true;
+			}
+		}
 
+		std::vector<size_t> misses;
+		for (size_t i = 0; i < batches.size(); ++i) {
+			if (!batches[i].is_emitted) {
+				misses.push_back(i);
+			}
+		}
+
+		// Промахи генерируются частями, у каждой части свой LLVMContext:
+		// создавать контекст на каждую подпрограмму дорого
+		const auto thread_count = pool != nullptr ? static_cast<size_t>(pool->getThreadCount()) : 0;
+		const auto part_count = std::min(misses.size(), std::max<size_t>(1, thread_count * kBatchesPerThread));
+		std::vector<std::vector<Batch*>> parts(part_count);
+		for (size_t i = 0; i < misses.size(); ++i) {
+			parts[i * part_count / misses.size()].push_back(&batches[misses[i]]);
+		}
+
+		for (const auto& part : parts) {
+			if (pool != nullptr) {
+				pool->async([this, program, &part] {
+					TraceThread trace_thread;
+					EmitBatches_(program, part, is_bounds_checking_);
+				});
+			} else {
+				EmitBatches_(program, part, is_bounds_checking_);
+			}
+		}
+		if (pool != nullptr) {
+			pool->wait();
+		}
+
+		for (auto i : misses) {
+			if (batches[i].is_emitted) {
+				cache.Store(keys[i], batches[i].bitcode);
+			}
+		}
+
+		if (!LinkBatches_(program, batches)) {
+			return false;
+		}
+		llvm::verifyModule(module_);
+	}
+	catch (...) {
+		return false;
+	}
+
+	return true;
+}
+
+void IrGenerator::Emit_(ProgramAstNodePtr program) {
 	DeclareSubroutines_(program);
 	DefineSubroutines_(program);
 
@@ -76,7 +215,7 @@ void IrGenerator::Emit_(ProgramAstNodePtr program) {
 }
 
 void IrGenerator::Emit_(SubroutineAstNodePtr subroutine) {
-	TRACE(Subroutine);
+	TRACE_DETAIL(EmitSubroutine, subroutine->GetName());
 
 	auto* function = module_.getFunction(subroutine->GetName());
 	if (function == nullptr) {
@@ -92,34 +231,53 @@ void IrGenerator::Emit_(SubroutineAstNodePtr subroutine) {
 	}
 
 	variable_addresses_.clear();
+	ssa_variables_.clear();
+	current_definitions_.clear();
+	incomplete_phis_.clear();
+	sealed_blocks_.clear();
+	SealBlock_(label_start);
+	integers_.emplace(subroutine);
 
 	std::list<llvm::Value*> local_text_variables;
-	std::list<llvm::Value*> local_array_variables;
 
 	for (const auto& local_variable : subroutine->local_variables) {
-		auto* llvm_type = local_variable->GetType() == DataType::kBoolean
-			? ir_builder_.getInt8Ty()
-			: ToLlvmType_(local_variable->GetType());  // TODO
-		auto* array_size = local_variable->GetType() == DataType::kArray
-			? llvm::ConstantInt::get(llvm::Type::getInt32Ty(context_), local_variable->array_size)
-			: nullptr;
-		auto* address = ir_builder_.CreateAlloca(llvm_type, array_size, local_variable->GetName() + "_addr");
+		// скалярные переменные — в SSA, до первого присваивания равны нулю
+		if (local_variable->OfType(DataType::kNumeric) || local_variable->OfType(DataType::kInteger) || local_variable->OfType(DataType::kBoolean)) {
+			auto* llvm_type = integers_->IsIntegral(local_variable->GetName())
+				? IntegerType_
+				: ToLlvmType_(local_variable->GetType());
+			ssa_variables_[local_variable->GetName()] = llvm_type;
+			WriteVariable_(local_variable->GetName(), label_start, llvm::Constant::getNullValue(llvm_type));
+			continue;
+		}
+
+		if (local_variable->OfType(DataType::kArray)) {
+			variable_addresses_[local_variable->GetName()] = CreateArray_(local_variable);
+			continue;
+		}
+
+		auto* llvm_type = ToLlvmType_(local_variable->GetType());  // TODO
+		auto* address = ir_builder_.CreateAlloca(llvm_type, nullptr, std::string{local_variable->GetName()} + "_addr");
 		variable_addresses_[local_variable->GetName()] = address;
 		if (local_variable->OfType(DataType::kTextual)) {
 			local_text_variables.push_back(address);
-		} else if (local_variable->OfType(DataType::kArray)) {
-			local_array_variables.push_back(address);
 		}
 	}
 
 	for (auto& arg : function->args()) {
+		const auto parameter = subroutine->GetParameters()[arg.getArgNo()];
+		if (IsSsaVariable_(parameter)) {
+			WriteVariable_(parameter, label_start, &arg);
+			continue;
+		}
+
+		auto* parameter_address = variable_addresses_[parameter];
 		if (arg.getType()->isPointerTy()) {
 			auto* parameter_value = CreateLibraryFunctionCall_("bsq_text_clone", {&arg});
-			ir_builder_.CreateStore(parameter_value, variable_addresses_[arg.getName().str()]);
-			local_text_variables.remove(variable_addresses_[arg.getName().str()]);
-			local_array_variables.remove(variable_addresses_[arg.getName().str()]);
+			ir_builder_.CreateStore(parameter_value, parameter_address);
+			local_text_variables.remove(parameter_address);
 		} else {
-			ir_builder_.CreateStore(&arg, variable_addresses_[arg.getName().str()]);
+			ir_builder_.CreateStore(&arg, parameter_address);
 		}
 	}
 
@@ -131,26 +289,38 @@ void IrGenerator::Emit_(SubroutineAstNodePtr subroutine) {
 
 	Emit_(subroutine->body);
 
-	// освобождение памяти под текстовые локальные переменные
+	// освобождение памяти под текстовые локальные переменные и массивы в куче
 	for (auto& local_variable : subroutine->local_variables) {
 		if (local_variable->GetName() == subroutine->GetName()) {
 			continue;
 		}
 
-		if (local_variable->OfType(DataType::kNumeric) || local_variable->OfType(DataType::kBoolean)) {
+		if (local_variable->OfType(DataType::kNumeric) || local_variable->OfType(DataType::kInteger) || local_variable->OfType(DataType::kBoolean)) {
 			continue;
 		}
 
 		if (DataType::kTextual == local_variable->GetType()) {
 			auto* address = ir_builder_.CreateLoad(TextualType_, variable_addresses_[local_variable->GetName()]);
 			CreateLibraryFunctionCall_("free", {address});
+		} else if (local_variable->OfType(DataType::kArray) && local_variable->array_size == 0) {
+			auto* descriptor = variable_addresses_[local_variable->GetName()];
+			auto* capacity = ir_builder_.CreateLoad(IntegerType_, ir_builder_.CreateStructGEP(ArrayType_, descriptor, 2));
+			CreateLibraryFunctionCall_("bsq_array_free", {EmitArray_(local_variable), capacity});
+		} else if (local_variable->OfType(DataType::kArray) && sIsHeapArray(local_variable)) {
+			auto* array_size = ir_builder_.getInt64(local_variable->array_size);
+			CreateLibraryFunctionCall_("bsq_array_free", {variable_addresses_[local_variable->GetName()], array_size});
 		}
 	}
 
 	if (function->getReturnType()->isVoidTy()) {
 		ir_builder_.CreateRetVoid();
 	} else {
-		auto return_value = ir_builder_.CreateLoad(function->getReturnType(), variable_addresses_[subroutine->GetName()]);
+		llvm::Value* return_value = IsSsaVariable_(subroutine->GetName())
+			? ReadVariable_(subroutine->GetName(), ir_builder_.GetInsertBlock())
+			: ir_builder_.CreateLoad(function->getReturnType(), variable_addresses_[subroutine->GetName()]);
+		if (integers_->IsIntegral(subroutine->GetName())) {
+			return_value = ir_builder_.CreateSIToFP(return_value, NumericType_);
+		}
 		ir_builder_.CreateRet(return_value);
 	}
 
@@ -158,58 +328,35 @@ void IrGenerator::Emit_(SubroutineAstNodePtr subroutine) {
 }
 
 void IrGenerator::Emit_(StatementAstNodePtr statement) {
-	switch (statement->GetNodeType()) {
-	case AstNodeType::kSequence:
-		Emit_(std::dynamic_pointer_cast<SequenceAstNode>(statement));
-		break;
-	case AstNodeType::kInput:
-		Emit_(std::dynamic_pointer_cast<InputAstNode>(statement));
-		break;
-	case AstNodeType::kPrint:
-		Emit_(std::dynamic_pointer_cast<PrintAstNode>(statement));
-		break;
-	case AstNodeType::kLet:
-		Emit_(std::dynamic_pointer_cast<LetAstNode>(statement));
-		break;
-	case AstNodeType::kIf:
-		Emit_(std::dynamic_pointer_cast<IfAstNode>(statement));
-		break;
-	case AstNodeType::kWhile:
-		Emit_(std::dynamic_pointer_cast<WhileAstNode>(statement));
-		break;
-	case AstNodeType::kFor:
-		Emit_(std::dynamic_pointer_cast<ForAstNode>(statement));
-		break;
-	case AstNodeType::kCall:
-		Emit_(std::dynamic_pointer_cast<CallAstNode>(statement));
-		break;
-	default:
-		break;
-	}
+	VisitStatement(statement, [this](auto node) { Emit_(node); });
 }
 
 void IrGenerator::Emit_(SequenceAstNodePtr sequence) {
-	TRACE(Sequence);
-
 	for (auto& statement : sequence->items) {
 		Emit_(statement);
 	}
 }
 
 void IrGenerator::Emit_(LetAstNodePtr let) {
-	TRACE(Let);
+	if (integers_->IsIntegral(let->variable->GetName())) {
+		AssignVariable_(let->variable->GetName(), EmitInteger_(let->expression));
+		return;
+	}
 
 	auto* value = Emit_(let->expression);
-	if (std::dynamic_pointer_cast<ItemAstNode>(let->expression)) {
+	if (AstNodeIs<ItemAstNode>(let->expression)) {
 		value = ir_builder_.CreateLoad(NumericType_, value);
 	}
+
+	if (IsSsaVariable_(let->variable->GetName())) {
+		WriteVariable_(let->variable->GetName(), ir_builder_.GetInsertBlock(), value);
+		return;
+	}
+
 	auto* address = variable_addresses_[let->variable->GetName()];
 
 	if (let->variable->OfType(DataType::kArray)) {
-		auto* result = Emit_(let->array_index);
-		auto* idx_p_1 = ir_builder_.CreateFPToSI(result, ir_builder_.getInt32Ty());
-		auto* idx = ir_builder_.CreateAdd(ir_builder_.getInt32(-1), idx_p_1);
-		address = ir_builder_.CreateGEP(NumericType_, address, idx);
+		address = EmitElement_(let->variable, let->array_index);
 	}
 	else if (let->variable->OfType(DataType::kTextual)) {
 		auto* load = ir_builder_.CreateLoad(TextualType_, address);
@@ -217,16 +364,47 @@ void IrGenerator::Emit_(LetAstNodePtr let) {
 		if (!NeedCreateTemporaryText_(let->expression)) {
 			value = CreateLibraryFunctionCall_("bsq_text_clone", {value});
 		}
-	} else if (let->variable->OfType(DataType::kBoolean)) {
-		value = ir_builder_.CreateZExt(value, ir_builder_.getInt8Ty());
 	}
 
 	ir_builder_.CreateStore(value, address);
 }
 
-void IrGenerator::Emit_(InputAstNodePtr input) {
-	TRACE(Input);
+void IrGenerator::Emit_(DimAstNodePtr dim) {
+	// память под массивы постоянного размера выделяется при входе в подпрограмму
+	if (dim->variable->array_size != 0) {
+		return;
+	}
+
+	auto* descriptor = variable_addresses_[dim->variable->GetName()];
+	auto* array_address = ir_builder_.CreateStructGEP(ArrayType_, descriptor, 0);
+	auto* length_address = ir_builder_.CreateStructGEP(ArrayType_, descriptor, 1);
+	auto* capacity_address = ir_builder_.CreateStructGEP(ArrayType_, descriptor, 2);
+	auto* array = ir_builder_.CreateLoad(NumericType_->getPointerTo(), array_address);
+	llvm::Value* length = ir_builder_.CreateLoad(IntegerType_, length_address);
+	auto* capacity = ir_builder_.CreateLoad(IntegerType_, capacity_address);
+	auto* new_length = EmitSize_(dim->size);
+
+	// REDIM PRESERVE растёт хотя бы вдвое, чтобы добавление элементов
+	// по одному стоило амортизированно O(1); DIM выделяет ровно нужное.
+	// Отрицательный размер не меняет ёмкость, его отвергает bsq_array_resize
+	llvm::Value* grown_capacity = new_length;
+	if (dim->is_preserving) {
+		auto* doubled_capacity = ir_builder_.CreateShl(capacity, 1);
+		grown_capacity = ir_builder_.CreateSelect(ir_builder_.CreateICmpSGT(new_length, doubled_capacity), new_length, doubled_capacity);
+	}
+	auto* new_capacity = ir_builder_.CreateSelect(ir_builder_.CreateICmpSGT(new_length, capacity), grown_capacity, capacity);
+
+	// DIM обнуляет массив: старые элементы не сохраняются
+	llvm::Value* kept_length = dim->is_preserving ? length : ir_builder_.getInt64(0);
+	auto* new_array = CreateLibraryFunctionCall_("bsq_array_resize", {array, kept_length, capacity, new_length, new_capacity});
+	new_array->addRetAttr(llvm::Attribute::getWithAlignment(context_, llvm::Align{kArrayAlignment}));
+
+	ir_builder_.CreateStore(new_array, array_address);
+	ir_builder_.CreateStore(new_length, length_address);
+	ir_builder_.CreateStore(new_capacity, capacity_address);
+}
 
+void IrGenerator::Emit_(InputAstNodePtr input) {
 	auto* prompt = Emit_(input->prompt);
 
 	std::string_view function_name;
@@ -236,6 +414,8 @@ void IrGenerator::Emit_(InputAstNodePtr input) {
 		function_name = "bool_input";
 	} else if (input->variable->OfType(DataType::kNumeric)) {
 		function_name = "bsq_number_input";
+	} else if (input->variable->OfType(DataType::kInteger)) {
+		function_name = "bsq_integer_input";
 	} else if (input->variable->OfType(DataType::kTextual)) {
 		function_name = "bsq_text_input";
 	}
@@ -243,19 +423,13 @@ void IrGenerator::Emit_(InputAstNodePtr input) {
 	auto* value = CreateLibraryFunctionCall_(function_name, {prompt});
 
 	if (input->item) {
-		auto* result = Emit_(input->item->expression);
-		auto* idx_p_1 = ir_builder_.CreateFPToSI(result, ir_builder_.getInt32Ty());
-		auto* idx = ir_builder_.CreateAdd(ir_builder_.getInt32(-1), idx_p_1);
-		auto* gep = ir_builder_.CreateGEP(ToLlvmType_(input->item->array->GetType()), variable_addresses_[input->item->array->GetName()], idx);
-		ir_builder_.CreateStore(value, gep);
+		ir_builder_.CreateStore(value, Emit_(input->item));
 	} else {
-		ir_builder_.CreateStore(value, variable_addresses_[input->variable->GetName()]);
+		AssignVariable_(input->variable->GetName(), value);
 	}
 }
 
 void IrGenerator::Emit_(PrintAstNodePtr print) {
-	TRACE(Print);
-
 	auto* expression = Emit_(print->expression);
 
 	if (print->expression->OfType(DataType::kBoolean)) {
@@ -266,25 +440,26 @@ void IrGenerator::Emit_(PrintAstNodePtr print) {
 			CreateLibraryFunctionCall_("free", {expression});
 		}
 	} else if (print->expression->OfType(DataType::kNumeric)) {
-		if (std::dynamic_pointer_cast<ItemAstNode>(print->expression)) {
+		if (AstNodeIs<ItemAstNode>(print->expression)) {
 			expression = ir_builder_.CreateLoad(NumericType_, expression);
 		}
 		CreateLibraryFunctionCall_("bsq_number_print", {expression});
+	} else if (print->expression->OfType(DataType::kInteger)) {
+		CreateLibraryFunctionCall_("bsq_integer_print", {expression});
 	}
 }
 
 void IrGenerator::Emit_(IfAstNodePtr if_node) {
-	TRACE(If);
-
 	auto* function = ir_builder_.GetInsertBlock()->getParent();
 
 	auto* end_if = llvm::BasicBlock::Create(context_, "", function);
 
 	auto* first = llvm::BasicBlock::Create(context_, "", function, end_if);
 	SetCurrentBlock_(function, first);
+	SealBlock_(first);
 
 	StatementAstNodePtr statement = if_node;
-	while (auto if_in_chain = std::dynamic_pointer_cast<IfAstNode>(statement)) {
+	while (auto if_in_chain = AstNodeCast<IfAstNode>(statement)) {
 		auto* then_block = llvm::BasicBlock::Create(context_, "", function, end_if);
 		auto* else_block = llvm::BasicBlock::Create(context_, "", function, end_if);
 
@@ -292,6 +467,8 @@ void IrGenerator::Emit_(IfAstNodePtr if_node) {
 		//condition = ir_builder_.CreateFCmpUNE(condition, Zero);
 
 		ir_builder_.CreateCondBr(condition, then_block, else_block);
+		SealBlock_(then_block);
+		SealBlock_(else_block);
 
 		SetCurrentBlock_(function, then_block);
 
@@ -308,11 +485,10 @@ void IrGenerator::Emit_(IfAstNodePtr if_node) {
 	}
 
 	SetCurrentBlock_(function, end_if);
+	SealBlock_(end_if);
 }
 
 void IrGenerator::Emit_(WhileAstNodePtr while_node) {
-	TRACE(While);
-
 	auto* function = ir_builder_.GetInsertBlock()->getParent();
 
 	auto* condition_block = llvm::BasicBlock::Create(context_, "", function);
@@ -323,98 +499,255 @@ void IrGenerator::Emit_(WhileAstNodePtr while_node) {
 
 	auto* condition_expression = Emit_(while_node->condition);
 	ir_builder_.CreateCondBr(condition_expression, body_block, end_while);
+	SealBlock_(body_block);
+	SealBlock_(end_while);
 
 	SetCurrentBlock_(function, body_block);
 
 	Emit_(while_node->body);
 	ir_builder_.CreateBr(condition_block);
+	SealBlock_(condition_block);
 
 	SetCurrentBlock_(function, end_while);
 }
 
 void IrGenerator::Emit_(ForAstNodePtr for_node) {
-	TRACE(For);
+	// целочисленный счётчик — i64 со сравнением icmp и сложением nsw,
+	// которые распознают анализы циклов LLVM; у INTEGER сложение
+	// с переполнением определено, поэтому оно проверяется, см. EmitLoop_
+	const auto parameter = for_node->variable->GetName();
+	const bool is_integer = for_node->variable->OfType(DataType::kInteger);
+	const bool is_integral = is_integer || integers_->IsIntegral(parameter);
+	const bool is_ascending = for_node->step->GetValue() > 0.0;
+
+	llvm::Value* begin = nullptr;
+	llvm::Value* end = nullptr;
+	llvm::Value* step = nullptr;
+	if (is_integer) {
+		begin = Emit_(for_node->begin);
+		end = Emit_(for_node->end);
+		step = ir_builder_.getInt64(for_node->step->GetIntegerValue());
+	} else if (is_integral) {
+		begin = EmitInteger_(for_node->begin);
+		end = integers_->IsIntegral(for_node->end)
+			? EmitInteger_(for_node->end)
+			: CreateLoopLimit_(Emit_(for_node->end), is_ascending);
+		step = ir_builder_.getInt64(static_cast<std::int64_t>(for_node->step->GetValue()));
+	} else {
+		begin = Emit_(for_node->begin);
+		end = Emit_(for_node->end);
+		step = llvm::ConstantFP::get(NumericType_, for_node->step->GetValue());
+	}
+	if (!is_integral) {
+		EmitNumericLoop_(for_node, begin, end, step);
+		return;
+	}
 
+	std::vector<LoopAccess> accesses;
+	llvm::Value* is_in_bounds = nullptr;
+	if (is_bounds_checking_ && is_integral && !is_in_versioned_loop_) {
+		accesses = CollectLoopAccesses(for_node);
+	}
+	if (!accesses.empty()) {
+		// счётчик пробегает [first, last]; переполнение на краях i64
+		// только делает промежуток непроходящим проверку
+		auto* one = ir_builder_.getInt64(1);
+		auto* first = is_ascending ? begin : ir_builder_.CreateAdd(end, one);
+		auto* last = is_ascending ? ir_builder_.CreateSub(end, one) : begin;
+		is_in_bounds = CreateLoopBoundsCheck_(accesses, first, last);
+	}
+	if (is_in_bounds == nullptr) {
+		EmitLoop_(for_node, begin, end, step);
+		return;
+	}
+
+	// версия цикла без проверок индексов, которые проверены перед циклом,
+	// и версия с проверками, которая доходит до ошибки в нужной итерации.
+	// Вложенные циклы обеих версий не делятся снова: иначе гнездо глубины d
+	// дало бы 2^d копий самого внутреннего тела
+	auto* function = ir_builder_.GetInsertBlock()->getParent();
+	auto* checked_block = llvm::BasicBlock::Create(context_, "", function);
+	auto* unchecked_block = llvm::BasicBlock::Create(context_, "", function);
+	auto* end_for = llvm::BasicBlock::Create(context_, "", function);
+	ir_builder_.CreateCondBr(is_in_bounds, unchecked_block, checked_block);
+	SealBlock_(checked_block);
+	SealBlock_(unchecked_block);
+
+	is_in_versioned_loop_ = true;
+
+	SetCurrentBlock_(function, unchecked_block);
+	for (const auto& access : accesses) {
+		in_bounds_indices_.insert(access.index);
+	}
+	EmitLoop_(for_node, begin, end, step);
+	for (const auto& access : accesses) {
+		in_bounds_indices_.erase(access.index);
+	}
+	ir_builder_.CreateBr(end_for);
+
+	SetCurrentBlock_(function, checked_block);
+	EmitLoop_(for_node, begin, end, step);
+
+	is_in_versioned_loop_ = false;
+
+	SetCurrentBlock_(function, end_for);
+	SealBlock_(end_for);
+}
+
+void IrGenerator::EmitLoop_(ForAstNodePtr for_node, llvm::Value* begin, llvm::Value* end, llvm::Value* step) {
 	auto* function = ir_builder_.GetInsertBlock()->getParent();
 
 	auto* condition_block = llvm::BasicBlock::Create(context_, "", function);
 	auto* body_block = llvm::BasicBlock::Create(context_, "", function);
 	auto* end_for = llvm::BasicBlock::Create(context_, "", function);
 
-	auto* parameter = variable_addresses_[for_node->variable->GetName()];
-	auto* begin = Emit_(for_node->begin);
-	ir_builder_.CreateStore(begin, parameter);
-	auto* end = Emit_(for_node->end);
-	auto* step = llvm::ConstantFP::get(NumericType_, for_node->step->GetValue());
+	const auto parameter = for_node->variable->GetName();
+	const bool is_integer = for_node->variable->OfType(DataType::kInteger);
+	const bool is_ascending = for_node->step->GetValue() > 0.0;
+
+	AssignVariable_(parameter, begin);
 
 	SetCurrentBlock_(function, condition_block);
 
-	auto* parameter_value = ir_builder_.CreateLoad(NumericType_, parameter);
-	llvm::Value* condition_expression = nullptr;
-	if (for_node->step->GetValue() > 0.0) {
-		condition_expression = ir_builder_.CreateFCmpOLT(parameter_value, end);
-	} else if (for_node->step->GetValue() < 0.0) {
-		condition_expression = ir_builder_.CreateFCmpOGT(parameter_value, end);
-	}
+	auto* parameter_value = ReadVariable_(parameter, ir_builder_.GetInsertBlock());
+	auto* condition_expression = is_ascending
+		? ir_builder_.CreateICmpSLT(parameter_value, end)
+		: ir_builder_.CreateICmpSGT(parameter_value, end);
 	ir_builder_.CreateCondBr(condition_expression, body_block, end_for);
+	SealBlock_(body_block);
 
 	SetCurrentBlock_(function, body_block);
 
 	Emit_(for_node->body);
 
-	auto* parameter_value2 = ir_builder_.CreateLoad(NumericType_, parameter);
-	auto* add = ir_builder_.CreateFAdd(parameter_value2, step);
-	ir_builder_.CreateStore(add, parameter);
+	// Сложение INTEGER идёт по модулю 2^64, и счётчик, перешагнувший
+	// предел i64, снова прошёл бы проверку: такой шаг завершает цикл.
+	// Счётчик остальных циклов ограничен kLoopLimit, и сложение nsw
+	parameter_value = ReadVariable_(parameter, ir_builder_.GetInsertBlock());
+	llvm::BranchInst* latch = nullptr;
+	if (is_integer) {
+		auto* sum = ir_builder_.CreateBinaryIntrinsic(llvm::Intrinsic::sadd_with_overflow, parameter_value, step);
+		AssignVariable_(parameter, ir_builder_.CreateExtractValue(sum, 0));
+		latch = ir_builder_.CreateCondBr(ir_builder_.CreateExtractValue(sum, 1), end_for, condition_block);
+	} else {
+		AssignVariable_(parameter, ir_builder_.CreateNSWAdd(parameter_value, step));
+		latch = ir_builder_.CreateBr(condition_block);
+	}
 
-	ir_builder_.CreateBr(condition_block);
+	if (!AssignsCounter(for_node)) {
+		MarkLoopMustProgress_(latch);
+	}
+	SealBlock_(condition_block);
+	SealBlock_(end_for);
 
 	SetCurrentBlock_(function, end_for);
 }
 
-void IrGenerator::Emit_(CallAstNodePtr call) {
-	TRACE(Call);
+void IrGenerator::EmitNumericLoop_(ForAstNodePtr for_node, llvm::Value* begin, llvm::Value* end, llvm::Value* step) {
+	auto* function = ir_builder_.GetInsertBlock()->getParent();
+	const auto parameter = for_node->variable->GetName();
+	const bool is_ascending = for_node->step->GetValue() > 0.0;
+	const bool is_counted = !AssignsCounter(for_node);
+
+	auto* zero = llvm::ConstantFP::get(NumericType_, 0.0);
+	auto* one = llvm::ConstantFP::get(NumericType_, 1.0);
+	auto counter_at = [&](llvm::Value* base, llvm::Value* ordinal) {
+		return ir_builder_.CreateFAdd(base, ir_builder_.CreateFMul(ordinal, step));
+	};
+	auto is_before_end = [&](llvm::Value* counter) {
+		return is_ascending ? ir_builder_.CreateFCmpOLT(counter, end) : ir_builder_.CreateFCmpOGT(counter, end);
+	};
+
+	llvm::Value* count = nullptr;
+	if (is_counted) {
+		// число k, при которых begin + k * step ещё до end. Частное округлено,
+		// и ceil может ошибиться на 1 в обе стороны: это исправляется сравнением
+		// тех же значений счётчика, что и в цикле. Отрицательное частное
+		// и NaN дают 0 итераций; fptosi.sat ограничивает слишком большое
+		count = ir_builder_.CreateFDiv(ir_builder_.CreateFSub(end, begin), step);
+		count = ir_builder_.CreateUnaryIntrinsic(llvm::Intrinsic::ceil, count);
+		count = ir_builder_.CreateIntrinsic(llvm::Intrinsic::fptosi_sat, {IntegerType_, NumericType_}, {count});
+		count = ir_builder_.CreateBinaryIntrinsic(llvm::Intrinsic::smax, count, ir_builder_.getInt64(0));
+
+		auto* previous = ir_builder_.CreateSub(count, ir_builder_.getInt64(1));
+		auto* is_too_many = ir_builder_.CreateAnd(
+			ir_builder_.CreateICmpSGT(count, ir_builder_.getInt64(0)),
+			ir_builder_.CreateNot(is_before_end(counter_at(begin, ir_builder_.CreateSIToFP(previous, NumericType_)))));
+		count = ir_builder_.CreateSelect(is_too_many, previous, count);
+
+		auto* next = ir_builder_.CreateBinaryIntrinsic(llvm::Intrinsic::sadd_sat, count, ir_builder_.getInt64(1));
+		auto* is_too_few = is_before_end(counter_at(begin, ir_builder_.CreateSIToFP(count, NumericType_)));
+		count = ir_builder_.CreateSelect(is_too_few, next, count, "count");
+	}
+
+	auto* preheader = ir_builder_.GetInsertBlock();
+	auto* condition_block = llvm::BasicBlock::Create(context_, "", function);
+	auto* body_block = llvm::BasicBlock::Create(context_, "", function);
+	auto* end_for = llvm::BasicBlock::Create(context_, "", function);
+
+	SetCurrentBlock_(function, condition_block);
+
+	// счётчик вычисляется в заголовке, чтобы после цикла он был равен
+	// первому значению, не прошедшему проверку. Номер шага хранится
+	// в double: sitofp i64 не векторизуется на SSE2, а сложения целых
+	// до 2^53 в double точны, поэтому их можно переставлять (reassoc)
+	auto* ordinal = ir_builder_.CreatePHI(NumericType_, 2, "ordinal");
+	ordinal->addIncoming(zero, preheader);
+	llvm::PHINode* iteration = nullptr;
+	llvm::PHINode* base = nullptr;
+	if (is_counted) {
+		iteration = ir_builder_.CreatePHI(IntegerType_, 2, "iteration");
+		iteration->addIncoming(ir_builder_.getInt64(0), preheader);
+	} else {
+		base = ir_builder_.CreatePHI(NumericType_, 2, "base");
+		base->addIncoming(begin, preheader);
+	}
+	auto* counter = counter_at(is_counted ? begin : base, ordinal);
+	AssignVariable_(parameter, counter);
+
+	auto* condition_expression = is_counted ? ir_builder_.CreateICmpSLT(iteration, count) : is_before_end(counter);
+	ir_builder_.CreateCondBr(condition_expression, body_block, end_for);
+	SealBlock_(body_block);
+	SealBlock_(end_for);
+
+	SetCurrentBlock_(function, body_block);
+
+	Emit_(for_node->body);
+
+	auto* latch = ir_builder_.GetInsertBlock();
+	auto* next_ordinal = llvm::cast<llvm::Instruction>(ir_builder_.CreateFAdd(ordinal, one));
+	next_ordinal->setHasAllowReassoc(true);
+	next_ordinal->setHasNoSignedZeros(true);
+	if (is_counted) {
+		ordinal->addIncoming(next_ordinal, latch);
+		iteration->addIncoming(ir_builder_.CreateNSWAdd(iteration, ir_builder_.getInt64(1)), latch);
+		MarkLoopMustProgress_(ir_builder_.CreateBr(condition_block));
+	} else {
+		// значение, присвоенное телом, становится новым началом отсчёта шагов;
+		// если тело оставило счётчик прежним, цикл идёт как без присваивания
+		auto* assigned = Emit_(for_node->variable);
+		auto* is_kept = ir_builder_.CreateFCmpOEQ(assigned, counter);
+		ordinal->addIncoming(ir_builder_.CreateSelect(is_kept, next_ordinal, one), latch);
+		base->addIncoming(ir_builder_.CreateSelect(is_kept, base, assigned), latch);
+		ir_builder_.CreateBr(condition_block);
+	}
+	SealBlock_(condition_block);
 
+	SetCurrentBlock_(function, end_for);
+}
+
+void IrGenerator::Emit_(CallAstNodePtr call) {
 	Emit_(call->subroutine_call);
 }
 
 llvm::Value* IrGenerator::Emit_(ExpressionAstNodePtr expression) {
-	llvm::Value* result = nullptr;
-
-	switch (expression->GetNodeType()) {
-	case AstNodeType::kBoolean:
-		result = Emit_(std::dynamic_pointer_cast<BooleanAstNode>(expression));
-		break;
-	case AstNodeType::kNumber:
-		result = Emit_(std::dynamic_pointer_cast<NumberAstNode>(expression));
-		break;
-	case AstNodeType::kText:
-		result = Emit_(std::dynamic_pointer_cast<TextAstNode>(expression));
-		break;
-	case AstNodeType::kVariable:
-		result = Emit_(std::dynamic_pointer_cast<VariableAstNode>(expression));
-		break;
-	case AstNodeType::kItem:
-		result = Emit_(std::dynamic_pointer_cast<ItemAstNode>(expression));
-		break;
-	case AstNodeType::kUnary:
-		result = Emit_(std::dynamic_pointer_cast<UnaryExpressionAstNode>(expression));
-		break;
-	case AstNodeType::kBinary:
-		result = Emit_(std::dynamic_pointer_cast<BinaryExpressionAstNode>(expression));
-		break;
-	case AstNodeType::kApply:
-		result = Emit_(std::dynamic_pointer_cast<ApplyAstNode>(expression));
-		break;
-	default:
-		break;
+	if (integers_->IsIntegralValue(expression) && !AstNodeIs<NumberAstNode>(expression)) {
+		return ir_builder_.CreateSIToFP(EmitInteger_(expression), NumericType_);
 	}
-
-	return result;
+	return VisitExpression(expression, [this](auto node) -> llvm::Value* { return Emit_(node); });
 }
 
 llvm::Value* IrGenerator::Emit_(TextAstNodePtr text) {
-	TRACE(Text);
-
 	if (const auto it = textual_constants_.find(text->GetValue()); it != textual_constants_.end()) {
 		return it->second;
 	}
@@ -426,53 +759,280 @@ llvm::Value* IrGenerator::Emit_(TextAstNodePtr text) {
 }
 
 llvm::Constant* IrGenerator::Emit_(NumberAstNodePtr number) {
-	TRACE(Number);
-
+	if (number->OfType(DataType::kInteger)) {
+		return ir_builder_.getInt64(number->GetIntegerValue());
+	}
 	return llvm::ConstantFP::get(NumericType_, number->GetValue());
 }
 
 llvm::Constant* IrGenerator::Emit_(BooleanAstNodePtr boolean) {
-	TRACE(BooleanAstNode);
-
 	return llvm::ConstantInt::getBool(BooleanType_, boolean->GetValue());
 }
 
-llvm::UnaryInstruction* IrGenerator::Emit_(VariableAstNodePtr variable) {
-	TRACE(Variable);
+llvm::Value* IrGenerator::Emit_(VariableAstNodePtr variable) {
+	if (integers_->IsIntegral(variable->GetName())) {
+		return ir_builder_.CreateSIToFP(ReadVariable_(variable->GetName(), ir_builder_.GetInsertBlock()), NumericType_);
+	}
+	if (IsSsaVariable_(variable->GetName())) {
+		return ReadVariable_(variable->GetName(), ir_builder_.GetInsertBlock());
+	}
 
 	auto* variable_address = variable_addresses_[variable->GetName()];
+	return ir_builder_.CreateLoad(ToLlvmType_(variable->GetType()), variable_address, variable->GetName());
+}
+
+llvm::Value* IrGenerator::Emit_(ItemAstNodePtr item) {
+	return EmitElement_(item->array, item->expression);
+}
+
+llvm::Value* IrGenerator::EmitElement_(VariableAstNodePtr array, ExpressionAstNodePtr index) {
+	auto* address = EmitArray_(array);
+	auto* offset = EmitIndex_(index);
 
-	if (variable->OfType(DataType::kBoolean)) {
-		llvm::Type* ByteType = ir_builder_.getInt8Ty();
-		llvm::LoadInst* result = ir_builder_.CreateLoad(ByteType, variable_address, variable->GetName());
-		return llvm::dyn_cast<llvm::UnaryInstruction>(ir_builder_.CreateTrunc(result, BooleanType_));  // TODO
+	if (is_bounds_checking_ && !IsInBounds_(array, index) && !in_bounds_indices_.contains(index)) {
+		llvm::Value* length = ir_builder_.getInt64(array->array_size);
+		if (array->array_size == 0) {
+			length = ir_builder_.CreateLoad(IntegerType_, ir_builder_.CreateStructGEP(ArrayType_, variable_addresses_[array->GetName()], 1));
+		}
+		// отрицательное смещение как беззнаковое больше любой длины
+		auto* is_out_of_range = ir_builder_.CreateICmpUGE(offset, length);
+		auto* index_value = ir_builder_.CreateAdd(offset, ir_builder_.getInt64(1));
+		CreateErrorCheck_(is_out_of_range, "bsq_index_out_of_range", {index_value, length});
 	}
 
-	return ir_builder_.CreateLoad(ToLlvmType_(variable->GetType()), variable_address, variable->GetName());
+	return ir_builder_.CreateGEP(NumericType_, address, offset);
 }
 
-llvm::Value* IrGenerator::Emit_(ItemAstNodePtr item) {
-	TRACE(Item);
+llvm::Value* IrGenerator::EmitArray_(VariableAstNodePtr array) {
+	auto* address = variable_addresses_[array->GetName()];
+	if (array->array_size != 0) {
+		return address;
+	}
+	return ir_builder_.CreateLoad(NumericType_->getPointerTo(), ir_builder_.CreateStructGEP(ArrayType_, address, 0));
+}
+
+llvm::Value* IrGenerator::EmitSize_(ExpressionAstNodePtr expression) {
+	if (expression->OfType(DataType::kInteger)) {
+		return Emit_(expression);
+	}
+	if (integers_->IsIntegral(expression)) {
+		return EmitInteger_(expression);
+	}
 
-	auto* result = Emit_(item->expression);
+	// NaN даёт 0, слишком большой размер — ошибку выделения памяти
+	auto* size = Emit_(expression);
+	if (AstNodeIs<ItemAstNode>(expression)) {
+		size = ir_builder_.CreateLoad(NumericType_, size);
+	}
+	return ir_builder_.CreateIntrinsic(llvm::Intrinsic::fptosi_sat, {IntegerType_, NumericType_}, {size});
+}
+
+llvm::Value* IrGenerator::EmitInteger_(ExpressionAstNodePtr expression) {
+	if (const auto* number = AstNodeCast<NumberAstNode>(expression)) {
+		return ir_builder_.getInt64(static_cast<std::int64_t>(number->GetValue()));
+	}
+	if (const auto* variable = AstNodeCast<VariableAstNode>(expression)) {
+		return ReadVariable_(variable->GetName(), ir_builder_.GetInsertBlock());
+	}
+	if (auto* unary = AstNodeCast<UnaryExpressionAstNode>(expression)) {
+		return ir_builder_.CreateNSWNeg(EmitInteger_(unary->GetOperand()), "neg");
+	}
+
+	// промежутки значений, выведенные IntegerInference, исключают переполнение
+	auto* binary = static_cast<BinaryExpressionAstNodePtr>(expression);
+	auto* lhs = EmitInteger_(binary->GetLeftOperand());
+	auto* rhs = EmitInteger_(binary->GetRightOperand());
+	switch (binary->GetOperation()) {
+	case Operation::kAdd: return ir_builder_.CreateNSWAdd(lhs, rhs, "add");
+	case Operation::kSub: return ir_builder_.CreateNSWSub(lhs, rhs, "sub");
+	case Operation::kMul: return ir_builder_.CreateNSWMul(lhs, rhs, "mul");
+	case Operation::kMod: return ir_builder_.CreateSRem(lhs, rhs, "rem");
+	default: return nullptr;  // невозможно
+	}
+}
+
+llvm::Value* IrGenerator::EmitIndex_(ExpressionAstNodePtr expression) {
+	if (expression->OfType(DataType::kInteger)) {
+		return ir_builder_.CreateAdd(Emit_(expression), ir_builder_.getInt64(-1));
+	}
+	if (integers_->IsIntegral(expression)) {
+		return ir_builder_.CreateNSWAdd(EmitInteger_(expression), ir_builder_.getInt64(-1));
+	}
+
+	auto* result = Emit_(expression);
+	if (is_bounds_checking_) {
+		// fptosi вне диапазона i32 даёт poison, который проверку не пройдёт
+		auto* index = ir_builder_.CreateIntrinsic(llvm::Intrinsic::fptosi_sat, {IntegerType_, NumericType_}, {result});
+		return ir_builder_.CreateAdd(index, ir_builder_.getInt64(-1));
+	}
 	auto* idx_p_1 = ir_builder_.CreateFPToSI(result, ir_builder_.getInt32Ty());
-	auto* idx = ir_builder_.CreateAdd(ir_builder_.getInt32(-1), idx_p_1);
-	return ir_builder_.CreateGEP(NumericType_, variable_addresses_[item->array->GetName()], idx);
+	return ir_builder_.CreateAdd(ir_builder_.getInt32(-1), idx_p_1);
 }
 
-llvm::Value* IrGenerator::Emit_(ApplyAstNodePtr apply) {
-	TRACE(Apply);
+llvm::Value* IrGenerator::CreateIntegerOperation_(Operation operation, llvm::Value* lhs, llvm::Value* rhs) {
+	if (const auto predicate = sIntegerPredicate(operation)) {
+		return ir_builder_.CreateICmp(*predicate, lhs, rhs, "cmp");
+	}
+
+	switch (operation) {
+	case Operation::kAdd: return ir_builder_.CreateAdd(lhs, rhs, "add");
+	case Operation::kSub: return ir_builder_.CreateSub(lhs, rhs, "sub");
+	case Operation::kMul: return ir_builder_.CreateMul(lhs, rhs, "mul");
+	case Operation::kIntDiv:
+	case Operation::kMod:
+		return CreateIntegerDivision_(operation, lhs, rhs);
+	case Operation::kDiv:
+		return ir_builder_.CreateFDiv(ir_builder_.CreateSIToFP(lhs, NumericType_), ir_builder_.CreateSIToFP(rhs, NumericType_), "div");
+	case Operation::kPow:
+		return CreateLibraryFunctionCall_("pow", {ir_builder_.CreateSIToFP(lhs, NumericType_), ir_builder_.CreateSIToFP(rhs, NumericType_)});
+	default:
+		return nullptr;
+	}
+}
+
+bool IrGenerator::IsInBounds_(VariableAstNodePtr array, ExpressionAstNodePtr index) const {
+	return array->array_size != 0 && integers_->IsWithin(index, 1.0, static_cast<double>(array->array_size));
+}
+
+llvm::Value* IrGenerator::CreateLoopBoundsCheck_(const std::vector<LoopAccess>& accesses, llvm::Value* first, llvm::Value* last) {
+	// наименьшее и наибольшее смещение индексов каждого массива
+	std::map<std::string_view, std::pair<std::int64_t, std::int64_t>> offsets;
+	std::vector<VariableAstNodePtr> arrays;
+	for (const auto& access : accesses) {
+		if (IsInBounds_(access.array, access.index)) {
+			continue;
+		}
+		const auto [it, is_inserted] = offsets.try_emplace(access.array->GetName(), access.offset, access.offset);
+		it->second.first = std::min(it->second.first, access.offset);
+		it->second.second = std::max(it->second.second, access.offset);
+		if (is_inserted) {
+			arrays.push_back(access.array);
+		}
+	}
+	if (arrays.empty()) {
+		return nullptr;
+	}
+
+	// first + min >= 1 и last + max <= длина; длина не больше 2^60,
+	// а смещения — 2^32, поэтому разности не переполняются
+	llvm::Value* is_in_bounds = ir_builder_.getTrue();
+	for (auto* array : arrays) {
+		const auto [min_offset, max_offset] = offsets[array->GetName()];
+		llvm::Value* length = ir_builder_.getInt64(array->array_size);
+		if (array->array_size == 0) {
+			length = ir_builder_.CreateLoad(IntegerType_, ir_builder_.CreateStructGEP(ArrayType_, variable_addresses_[array->GetName()], 1));
+		}
+		auto* is_first_in_bounds = ir_builder_.CreateICmpSGE(first, ir_builder_.getInt64(1 - min_offset));
+		auto* is_last_in_bounds = ir_builder_.CreateICmpSLE(last, ir_builder_.CreateSub(length, ir_builder_.getInt64(max_offset)));
+		is_in_bounds = ir_builder_.CreateAnd(is_in_bounds, ir_builder_.CreateAnd(is_first_in_bounds, is_last_in_bounds));
+	}
+	return is_in_bounds;
+}
+
+void IrGenerator::CreateErrorCheck_(llvm::Value* is_failed, std::string_view function_name, const llvm::ArrayRef<llvm::Value*>& arguments) {
+	auto* function = ir_builder_.GetInsertBlock()->getParent();
+
+	auto* error_block = llvm::BasicBlock::Create(context_, "", function);
+	auto* continue_block = llvm::BasicBlock::Create(context_, "", function);
+	auto* weights = llvm::MDBuilder{context_}.createBranchWeights(kErrorBranchWeight, kContinueBranchWeight);
+	ir_builder_.CreateCondBr(is_failed, error_block, continue_block, weights);
+	SealBlock_(error_block);
+	SealBlock_(continue_block);
+
+	SetCurrentBlock_(function, error_block);
+	auto* call = CreateLibraryFunctionCall_(function_name, arguments);
+	call->setDoesNotReturn();
+	call->addFnAttr(llvm::Attribute::Cold);
+	ir_builder_.CreateUnreachable();
+
+	SetCurrentBlock_(function, continue_block);
+}
+
+llvm::Value* IrGenerator::CreateIntegerDivision_(Operation operation, llvm::Value* lhs, llvm::Value* rhs) {
+	CreateErrorCheck_(ir_builder_.CreateICmpEQ(rhs, ir_builder_.getInt64(0)), "bsq_division_by_zero", {});
+
+	// деление INT64_MIN на -1 переполняется: делитель -1 заменяется на 1,
+	// тогда остаток равен 0, а частное — -lhs
+	auto* is_minus_one = ir_builder_.CreateICmpEQ(rhs, ir_builder_.getInt64(-1));
+	auto* divisor = ir_builder_.CreateSelect(is_minus_one, ir_builder_.getInt64(1), rhs);
+	if (Operation::kMod == operation) {
+		return ir_builder_.CreateSRem(lhs, divisor, "rem");
+	}
+	auto* quotient = ir_builder_.CreateSDiv(lhs, divisor, "quot");
+	return ir_builder_.CreateSelect(is_minus_one, ir_builder_.CreateNeg(lhs), quotient);
+}
 
+llvm::Value* IrGenerator::CreateArray_(VariableAstNodePtr array) {
+	const auto name = std::string{array->GetName()} + "_addr";
+	if (array->array_size == 0) {
+		auto* descriptor = ir_builder_.CreateAlloca(ArrayType_, nullptr, name);
+		ir_builder_.CreateStore(llvm::Constant::getNullValue(ArrayType_), descriptor);
+		return descriptor;
+	}
+	if (!sIsHeapArray(array)) {
+		auto* address = ir_builder_.CreateAlloca(NumericType_, ir_builder_.getInt64(array->array_size), name);
+		address->setAlignment(llvm::Align{kArrayAlignment});
+		return address;
+	}
+
+	// атрибуты результата видны оптимизатору, так как bsq_array_alloc
+	// не встраивается
+	auto* address = CreateLibraryFunctionCall_("bsq_array_alloc", {ir_builder_.getInt64(array->array_size)});
+	address->setName(name);
+	address->addRetAttr(llvm::Attribute::NoAlias);
+	address->addRetAttr(llvm::Attribute::getWithAlignment(context_, llvm::Align{kArrayAlignment}));
+	address->addRetAttr(llvm::Attribute::getWithDereferenceableBytes(context_, array->array_size * sizeof(double)));
+	return address;
+}
+
+llvm::Value* IrGenerator::CreateLoopLimit_(llvm::Value* end, bool is_ascending) {
+	auto* loop_limit = llvm::ConstantFP::get(NumericType_, IntegerInference::kLoopLimit);
+	auto* exact_limit = llvm::ConstantFP::get(NumericType_, IntegerInference::kExactLimit);
+
+	// minnum и maxnum возвращают число, если другой операнд — NaN
+	llvm::Value* limit = nullptr;
+	if (is_ascending) {
+		limit = ir_builder_.CreateUnaryIntrinsic(llvm::Intrinsic::ceil, end);
+		limit = ir_builder_.CreateMaxNum(limit, llvm::ConstantExpr::getFNeg(exact_limit));
+		limit = ir_builder_.CreateMinNum(limit, loop_limit);
+	} else {
+		limit = ir_builder_.CreateUnaryIntrinsic(llvm::Intrinsic::floor, end);
+		limit = ir_builder_.CreateMinNum(limit, exact_limit);
+		limit = ir_builder_.CreateMaxNum(limit, llvm::ConstantExpr::getFNeg(loop_limit));
+	}
+	return ir_builder_.CreateFPToSI(limit, IntegerType_, "limit");
+}
+
+void IrGenerator::MarkLoopMustProgress_(llvm::BranchInst* latch) {
+	// первый операнд — ссылка узла на себя, как требует формат llvm.loop
+	llvm::Metadata* operands[] = {nullptr, llvm::MDNode::get(context_, llvm::MDString::get(context_, "llvm.loop.mustprogress"))};
+	auto* loop_id = llvm::MDNode::getDistinct(context_, operands);
+	loop_id->replaceOperandWith(0, loop_id);
+	latch->setMetadata(llvm::LLVMContext::MD_loop, loop_id);
+}
+
+llvm::Value* IrGenerator::Emit_(ApplyAstNodePtr apply) {
 	llvm::SmallVector<llvm::Value*> arguments, temporaries;
 	for (const auto& argument : apply->GetArguments()) {
 		auto arg = Emit_(argument);
+		if (AstNodeIs<ItemAstNode>(argument)) {
+			arg = ir_builder_.CreateLoad(NumericType_, arg);
+		}
 		arguments.push_back(arg);
 		if (NeedCreateTemporaryText_(argument)) {
 			temporaries.push_back(arg);
 		}
 	}
 
-	auto callee = UserFunction_(apply->GetCallee()->GetName());
+	// явные преобразования типов — инструкции, а не вызовы
+	if (apply->GetCallee()->is_builtin && "FIX%" == apply->GetCallee()->GetName()) {
+		return ir_builder_.CreateIntrinsic(llvm::Intrinsic::fptosi_sat, {IntegerType_, NumericType_}, arguments);
+	}
+	if (apply->GetCallee()->is_builtin && "CDBL" == apply->GetCallee()->GetName()) {
+		return ir_builder_.CreateSIToFP(arguments.front(), NumericType_);
+	}
+
+	auto callee = UserFunction_(apply->GetCallee());
 	auto* call = ir_builder_.CreateCall(callee, arguments);
 
 	for (auto* temporary : temporaries) {
@@ -485,8 +1045,6 @@ llvm::Value* IrGenerator::Emit_(ApplyAstNodePtr apply) {
 }
 
 llvm::Value* IrGenerator::Emit_(BinaryExpressionAstNodePtr binary) {
-	TRACE(Binary);
-
 	const bool is_textual = binary->GetLeftOperand()->OfType(DataType::kTextual)
 		&& binary->GetRightOperand()->OfType(DataType::kTextual);
 	const bool is_numeric = binary->GetLeftOperand()->OfType(DataType::kNumeric)
@@ -494,12 +1052,24 @@ llvm::Value* IrGenerator::Emit_(BinaryExpressionAstNodePtr binary) {
 	const bool is_boolean = binary->GetLeftOperand()->OfType(DataType::kBoolean)
 		&& binary->GetRightOperand()->OfType(DataType::kBoolean);
 
+	if (binary->GetLeftOperand()->OfType(DataType::kInteger)) {
+		return CreateIntegerOperation_(binary->GetOperation(), Emit_(binary->GetLeftOperand()), Emit_(binary->GetRightOperand()));
+	}
+
+	// целые сравниваются точно, в том числе -0 с 0
+	if (const auto predicate = sIntegerPredicate(binary->GetOperation()); predicate
+		&& integers_->IsIntegral(binary->GetLeftOperand()) && integers_->IsIntegral(binary->GetRightOperand())) {
+		auto* lhs = EmitInteger_(binary->GetLeftOperand());
+		auto* rhs = EmitInteger_(binary->GetRightOperand());
+		return ir_builder_.CreateICmp(*predicate, lhs, rhs, "cmp");
+	}
+
 	auto* lhs = Emit_(binary->GetLeftOperand());
-	if (std::dynamic_pointer_cast<ItemAstNode>(binary->GetLeftOperand())) {
+	if (AstNodeIs<ItemAstNode>(binary->GetLeftOperand())) {
 		lhs = ir_builder_.CreateLoad(NumericType_, lhs);
 	}
 	auto* rhs = Emit_(binary->GetRightOperand());
-	if (std::dynamic_pointer_cast<ItemAstNode>(binary->GetRightOperand())) {
+	if (AstNodeIs<ItemAstNode>(binary->GetRightOperand())) {
 		rhs = ir_builder_.CreateLoad(NumericType_, rhs);
 	}
 
@@ -589,12 +1159,12 @@ llvm::Value* IrGenerator::Emit_(BinaryExpressionAstNodePtr binary) {
 }
 
 llvm::Value* IrGenerator::Emit_(UnaryExpressionAstNodePtr unary) {
-	TRACE(Unary);
-
 	auto* operand = Emit_(unary->GetOperand());
 
 	if (Operation::kSub == unary->GetOperation()) {
-		return ir_builder_.CreateFNeg(operand, "neg");
+		return unary->OfType(DataType::kInteger)
+			? ir_builder_.CreateNeg(operand, "neg")
+			: ir_builder_.CreateFNeg(operand, "neg");
 	}
 
 	if (Operation::kNot == unary->GetOperation()) {
@@ -618,11 +1188,122 @@ void IrGenerator::SetCurrentBlock_(llvm::Function* function, llvm::BasicBlock* b
 //		function->getBasicBlockList().push_back(basic_block);
 //	}
 
-	function->getBasicBlockList().push_back(basic_block);
+	// блок, уже созданный в функции, переносится в конец, а не добавляется
+	// в список второй раз: иначе список блоков функции портится
+	if (basic_block->getParent() == nullptr) {
+		function->getBasicBlockList().push_back(basic_block);
+	} else {
+		basic_block->moveAfter(&function->back());
+	}
 
 	ir_builder_.SetInsertPoint(basic_block);
 }
 
+void IrGenerator::AssignVariable_(std::string_view name, llvm::Value* value) {
+	if (IsSsaVariable_(name)) {
+		WriteVariable_(name, ir_builder_.GetInsertBlock(), value);
+	} else {
+		ir_builder_.CreateStore(value, variable_addresses_[name]);
+	}
+}
+
+bool IrGenerator::IsSsaVariable_(std::string_view name) const {
+	return ssa_variables_.contains(name);
+}
+
+void IrGenerator::WriteVariable_(std::string_view name, llvm::BasicBlock* block, llvm::Value* value) {
+	current_definitions_[block][name] = value;
+}
+
+llvm::Value* IrGenerator::ReadVariable_(std::string_view name, llvm::BasicBlock* block) {
+	if (const auto it = current_definitions_.find(block); it != current_definitions_.end()) {
+		if (const auto definition = it->second.find(name); definition != it->second.end()) {
+			return definition->second;
+		}
+	}
+	return ReadVariableRecursive_(name, block);
+}
+
+llvm::Value* IrGenerator::ReadVariableRecursive_(std::string_view name, llvm::BasicBlock* block) {
+	auto* type = ssa_variables_.at(name);
+
+	llvm::Value* value = nullptr;
+	if (!sealed_blocks_.contains(block)) {
+		// предшественники ещё не все известны: операнды добавит SealBlock_
+		auto* phi = block->empty()
+			? llvm::PHINode::Create(type, 0, name, block)
+			: llvm::PHINode::Create(type, 0, name, &block->front());
+		incomplete_phis_[block].emplace_back(name, phi);
+		value = phi;
+	} else if (auto* predecessor = block->getSinglePredecessor()) {
+		value = ReadVariable_(name, predecessor);
+	} else {
+		// φ-функция записывается до чтения операндов, чтобы разорвать циклы
+		auto* phi = block->empty()
+			? llvm::PHINode::Create(type, 0, name, block)
+			: llvm::PHINode::Create(type, 0, name, &block->front());
+		WriteVariable_(name, block, phi);
+		value = AddPhiOperands_(name, phi);
+	}
+
+	WriteVariable_(name, block, value);
+	return value;
+}
+
+llvm::Value* IrGenerator::AddPhiOperands_(std::string_view name, llvm::PHINode* phi) {
+	auto* block = phi->getParent();
+	for (auto* predecessor : llvm::predecessors(block)) {
+		phi->addIncoming(ReadVariable_(name, predecessor), predecessor);
+	}
+	return TryRemoveTrivialPhi_(phi);
+}
+
+llvm::Value* IrGenerator::TryRemoveTrivialPhi_(llvm::PHINode* phi) {
+	llvm::Value* same = nullptr;
+	for (llvm::Value* operand : phi->incoming_values()) {
+		if (operand == same || operand == phi) {
+			continue;
+		}
+		if (same != nullptr) {
+			return phi;  // φ-функция сливает разные значения
+		}
+		same = operand;
+	}
+
+	if (same == nullptr) {
+		same = llvm::UndefValue::get(phi->getType());  // недостижимый блок
+	}
+
+	// после замены φ-функции её пользователи-φ могли стать тривиальными
+	llvm::SmallVector<llvm::WeakVH> phi_users;
+	for (auto* user : phi->users()) {
+		if (user != phi && llvm::isa<llvm::PHINode>(user)) {
+			phi_users.emplace_back(user);
+		}
+	}
+
+	phi->replaceAllUsesWith(same);
+	phi->eraseFromParent();
+
+	for (auto& user : phi_users) {
+		if (auto* user_phi = llvm::dyn_cast_or_null<llvm::PHINode>(user)) {
+			TryRemoveTrivialPhi_(user_phi);
+		}
+	}
+	return same;
+}
+
+void IrGenerator::SealBlock_(llvm::BasicBlock* block) {
+	if (const auto it = incomplete_phis_.find(block); it != incomplete_phis_.end()) {
+		const auto phis = std::move(it->second);
+		incomplete_phis_.erase(it);
+		for (const auto& [name, phi] : phis) {
+			AddPhiOperands_(name, phi);
+		}
+	}
+	sealed_blocks_.insert(block);
+}
+
 void IrGenerator::PrepareLibrary_() {
 	DeclareLibraryFunction_("bsq_text_clone", "T(T)");
 	DeclareLibraryFunction_("bsq_text_input", "T(T)");
@@ -639,6 +1320,10 @@ void IrGenerator::PrepareLibrary_() {
 
 	DeclareLibraryFunction_("bsq_number_input", "N(T)");
 	DeclareLibraryFunction_("bsq_number_print", "V(N)");
+	DeclareLibraryFunction_("bsq_integer_input", "I(T)");
+	DeclareLibraryFunction_("bsq_integer_print", "V(I)");
+	DeclareLibraryFunction_("bsq_division_by_zero", "V()");
+	DeclareLibraryFunction_("bsq_index_out_of_range", "V(II)");
 
 	DeclareLibraryFunction_("pow", "N(NN)");
 	DeclareLibraryFunction_("sqrt", "N(N)");
@@ -649,6 +1334,17 @@ void IrGenerator::PrepareLibrary_() {
 	library_functions_["free"] = llvm::FunctionType::get(
 		VoidType_, {ir_builder_.getInt8PtrTy()}, false
 	);
+	library_functions_["bsq_array_alloc"] = llvm::FunctionType::get(
+		NumericType_->getPointerTo(), {ir_builder_.getInt64Ty()}, false
+	);
+	library_functions_["bsq_array_free"] = llvm::FunctionType::get(
+		VoidType_, {NumericType_->getPointerTo(), ir_builder_.getInt64Ty()}, false
+	);
+	library_functions_["bsq_array_resize"] = llvm::FunctionType::get(
+		NumericType_->getPointerTo(),
+		{NumericType_->getPointerTo(), IntegerType_, IntegerType_, IntegerType_, IntegerType_},
+		false
+	);
 }
 
 void IrGenerator::DeclareLibraryFunction_(std::string_view name, std::string_view signature) {
@@ -670,7 +1366,9 @@ llvm::FunctionCallee IrGenerator::LibraryFunction_(std::string_view name) {
 	return module_.getOrInsertFunction(name, library_functions_[std::string{name}]);
 }
 
-llvm::FunctionCallee IrGenerator::UserFunction_(std::string_view name) {
+llvm::FunctionCallee IrGenerator::UserFunction_(SubroutineAstNodePtr subroutine) {
+	const auto name = subroutine->GetName();
+
 	if ("MID$" == name) {
 		return LibraryFunction_("bsq_text_mid");
 	}
@@ -683,7 +1381,12 @@ llvm::FunctionCallee IrGenerator::UserFunction_(std::string_view name) {
 		return LibraryFunction_("sqrt");
 	}
 
-	return module_.getFunction(name);
+	if (auto* function = module_.getFunction(name)) {
+		return function;
+	}
+
+	// пакет параллельной генерации объявляет подпрограммы при первом вызове
+	return DeclareSubroutine_(subroutine);
 }
 
 void IrGenerator::CreateEntryPoint_() {
@@ -706,27 +1409,170 @@ void IrGenerator::CreateEntryPoint_() {
 
 void IrGenerator::DeclareSubroutines_(ProgramAstNodePtr program) {
 	for (const auto& subroutine : program->subroutines) {
-		llvm::SmallVector<llvm::Type*> parameters_types;
-		for (const auto& parameter : subroutine->GetParameters()) {
-			parameters_types.push_back(ToLlvmType_(parameter));
+		DeclareSubroutine_(subroutine);
+	}
+}
+
+llvm::Function* IrGenerator::DeclareSubroutine_(SubroutineAstNodePtr subroutine) {
+	llvm::SmallVector<llvm::Type*> parameters_types;
+	for (const auto& parameter : subroutine->GetParameters()) {
+		parameters_types.push_back(ToLlvmType_(parameter));
+	}
+
+	llvm::Type* return_type = subroutine->is_returning_value
+		? ToLlvmType_(subroutine->GetName())
+		: ir_builder_.getVoidTy();
+
+	auto* function_type = llvm::FunctionType::get(return_type, parameters_types, false);
+	const auto linkage = llvm::GlobalValue::ExternalLinkage;
+	return llvm::Function::Create(function_type, linkage, subroutine->GetName(), &module_);
+}
+
+void IrGenerator::DefineSubroutines_(ProgramAstNodePtr program) {
+	DefineSubroutines_(program, 0, program->subroutines.size());
+}
+
+void IrGenerator::DefineSubroutines_(ProgramAstNodePtr program, size_t first, size_t last) {
+	for (size_t i = first; i < last; ++i) {
+		if (const auto& subroutine = program->subroutines[i]; !subroutine->is_builtin) {
+			Emit_(subroutine);
 		}
+	}
+}
 
-		llvm::Type* return_type = subroutine->is_returning_value
-			? ToLlvmType_(subroutine->GetName())
-			: ir_builder_.getVoidTy();
+void IrGenerator::EmitBatches_(ProgramAstNodePtr program, const std::vector<Batch*>& batches, bool is_bounds_checking) {
+	TRACE(EmitBatches);
+
+	llvm::LLVMContext context;
+	for (auto* batch : batches) {
+		try {
+			llvm::Module module{"batch", context};
+			IrGenerator generator{context, module, is_bounds_checking};
+
+			// Объявляются только подпрограммы пакета, а вызываемые ими —
+			// в UserFunction_: объявления всех подпрограмм в каждом пакете
+			// только удлинили бы bitcode и связывание
+			const auto& subroutines = program->subroutines;
+			for (size_t i = batch->first; i < batch->last; ++i) {
+				if (!subroutines[i]->is_builtin) {
+					generator.DeclareSubroutine_(subroutines[i]);
+				}
+			}
+			generator.DefineSubroutines_(program, batch->first, batch->last);
+
+			llvm::raw_string_ostream out{batch->bitcode};
+			llvm::WriteBitcodeToFile(module, out);
+			batch->is_emitted = true;
+		}
+		catch (...) {
+			// пакет и все следующие за ним не связываются
+		}
+	}
+}
+
+bool IrGenerator::LinkBatches_(ProgramAstNodePtr program, const std::vector<Batch>& batches) {
+	TRACE(LinkBatches);
 
-		auto* function_type = llvm::FunctionType::get(return_type, parameters_types, false);
-		const auto linkage = llvm::GlobalValue::ExternalLinkage;
-		llvm::Function::Create(function_type, linkage, subroutine->GetName(), &module_);
+	for (const auto& batch : batches) {
+		if (!batch.is_emitted) {
+			return false;
+		}
 	}
+
+	DeclareSubroutines_(program);
+
+	// Пакеты переносит IRMover, а не Linker: Linker при каждом связывании
+	// обходит весь модуль, и связывание тысяч пакетов по одной
+	// подпрограмме заняло бы квадратичное время
+	llvm::IRMover mover{module_};
+	std::vector<std::string> functions;
+	std::vector<llvm::Constant*> texts;
+	for (const auto& batch : batches) {
+		LinkBatch_(mover, batch.bitcode, functions, texts);
+	}
+	RestoreOrder_(program, functions, texts);
+
+	CreateEntryPoint_();  // main()
+	return true;
 }
 
-void IrGenerator::DefineSubroutines_(ProgramAstNodePtr program) {
+void IrGenerator::LinkBatch_(llvm::IRMover& mover, llvm::StringRef bitcode, std::vector<std::string>& functions, std::vector<llvm::Constant*>& texts) {
+	auto batch = llvm::parseBitcodeFile(llvm::MemoryBufferRef{bitcode, "batch"}, context_);
+	if (!batch) {
+		llvm::consumeError(batch.takeError());
+		throw std::runtime_error{"не удалось прочитать модуль пакета"};
+	}
+
+	// библиотечные функции объявляются в порядке первого вызова
+	for (auto& function : (*batch)->functions()) {
+		if (library_functions_.contains(function.getName().str())) {
+			functions.push_back(function.getName().str());
+		}
+	}
+
+	// других глобальных переменных, кроме строковых констант, нет
+	for (auto& global : (*batch)->globals()) {
+		texts.push_back(global.getInitializer());
+	}
+
+	// Переносятся определения; объявления, на которые они ссылаются,
+	// связываются с уже объявленными в модуле или объявляются в нём
+	std::vector<llvm::GlobalValue*> definitions;
+	for (auto& value : (*batch)->global_values()) {
+		if (!value.isDeclaration()) {
+			definitions.push_back(&value);
+		}
+	}
+
+	auto error = mover.move(std::move(*batch), definitions, [](llvm::GlobalValue&, llvm::IRMover::ValueAdder) {}, false);
+	if (error) {
+		llvm::consumeError(std::move(error));
+		throw std::runtime_error{"не удалось связать модуль пакета"};
+	}
+}
+
+void IrGenerator::RestoreOrder_(ProgramAstNodePtr program, const std::vector<std::string>& functions, const std::vector<llvm::Constant*>& texts) {
+	// подпрограммы в порядке объявления, за ними библиотечные функции
+	auto& function_list = module_.getFunctionList();
+	std::unordered_set<llvm::Function*> placed;
+	auto place = [&function_list, &placed](llvm::Function* function) {
+		if (function != nullptr && placed.insert(function).second) {
+			function_list.splice(function_list.end(), function_list, function->getIterator());
+		}
+	};
 	for (const auto& subroutine : program->subroutines) {
-		if (!subroutine->is_builtin) {
-			Emit_(subroutine);
+		place(module_.getFunction(subroutine->GetName()));
+	}
+	for (const auto& name : functions) {
+		place(module_.getFunction(name));
+	}
+
+	// Константы с одинаковым текстом из разных пакетов объединяются,
+	// как их объединяет textual_constants_. Инициализаторы уникальны
+	// в пределах контекста, поэтому их можно сравнивать по указателю.
+	std::unordered_map<llvm::Constant*, llvm::GlobalVariable*> globals;
+	for (auto& global : llvm::make_early_inc_range(module_.globals())) {
+		if (auto [it, is_inserted] = globals.emplace(global.getInitializer(), &global); !is_inserted) {
+			global.replaceAllUsesWith(it->second);
+			global.eraseFromParent();
 		}
 	}
+
+	auto& global_list = module_.getGlobalList();
+	for (auto* text : texts) {
+		if (auto it = globals.find(text); it != globals.end() && it->second != nullptr) {
+			auto* global = std::exchange(it->second, nullptr);
+			global_list.splice(global_list.end(), global_list, global->getIterator());
+			global->setName("");
+		}
+	}
+
+	// имена, которые дала бы последовательная генерация: g_str, g_str.1, ...
+	size_t index = 0;
+	for (auto& global : module_.globals()) {
+		global.setName(index == 0 ? "g_str" : "g_str." + std::to_string(index));
+		++index;
+	}
 }
 
 llvm::Type* IrGenerator::ToLlvmType_(DataType type) {
@@ -735,6 +1581,8 @@ llvm::Type* IrGenerator::ToLlvmType_(DataType type) {
 		return BooleanType_;
 	case DataType::kNumeric:
 		return NumericType_;
+	case DataType::kInteger:
+		return IntegerType_;
 	case DataType::kTextual:
 		return TextualType_;
 	case DataType::kArray:
@@ -750,7 +1598,7 @@ llvm::Type* IrGenerator::ToLlvmType_(std::string_view name) {
 
 bool IrGenerator::NeedCreateTemporaryText_(ExpressionAstNodePtr expression) {
 	// для чисел не создаются временные объекты
-	if (expression->OfType(DataType::kNumeric) || expression->OfType(DataType::kBoolean)) {
+	if (expression->OfType(DataType::kNumeric) || expression->OfType(DataType::kInteger) || expression->OfType(DataType::kBoolean)) {
 		return false;
 	}
 
@@ -1,14 +1,22 @@
 #pragma once
 
 #include "ast.hpp"
+#include "integer_inference.hpp"
+#include "loop_accesses.hpp"
+#include "subroutine_cache.hpp"
 
 #include <llvm/ADT/ArrayRef.h>
 #include <llvm/IR/IRBuilder.h>
+#include <llvm/IR/ValueHandle.h>
 
 #include <memory>
+#include <optional>
 #include <string>
 #include <string_view>
 #include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
 
 
 namespace llvm {
@@ -17,8 +25,11 @@ class BasicBlock;
 class CallInst;
 class Constant;
 class Function;
+class IRMover;
 class LLVMContext;
 class Module;
+class PHINode;
+class ThreadPool;
 class Type;
 class UnaryInstruction;
 class Value;
@@ -30,10 +41,40 @@ namespace bsq {
 
 class IrGenerator {
 public:
-	IrGenerator(llvm::LLVMContext&, llvm::Module&);
+	/// @p is_bounds_checking — проверять индексы массивов, см. EmitElement_
+	IrGenerator(llvm::LLVMContext&, llvm::Module&, bool is_bounds_checking = false);
 
 	bool Emit(ProgramAstNodePtr);
 
+	/// @brief То же, что Emit(ProgramAstNodePtr), но подпрограммы
+	/// генерируются пакетами в потоках @p pool
+	///
+	/// Каждый пакет генерируется в собственных LLVMContext и модуле,
+	/// затем модули переносятся в контекст генератора через bitcode
+	/// и объединяются llvm::IRMover. Порядок и имена функций и строковых
+	/// констант восстанавливаются, поэтому модуль совпадает с результатом
+	/// последовательной генерации.
+	bool Emit(ProgramAstNodePtr, llvm::ThreadPool& pool);
+
+	/// @brief То же, что Emit(ProgramAstNodePtr), но IR подпрограмм
+	/// берётся из @p cache
+	///
+	/// Подпрограмма, которой нет в кэше, генерируется в собственном модуле
+	/// (потоками @p pool, если он задан) и сохраняется в кэш. Модули
+	/// подпрограмм связываются так же, как пакеты параллельной генерации.
+	/// Трассировка выводится только для сгенерированных подпрограмм.
+	bool Emit(ProgramAstNodePtr, SubroutineCache& cache, llvm::ThreadPool* pool);
+
+private:
+	/// Подпрограммы program->subroutines[first, last), сгенерированные
+	/// в отдельном модуле
+	struct Batch {
+		size_t first = 0;
+		size_t last = 0;
+		std::string bitcode;
+		bool is_emitted = false;
+	};
+
 private:
 	void Emit_(ProgramAstNodePtr);
 	void Emit_(SubroutineAstNodePtr);
@@ -41,10 +82,25 @@ private:
 	void Emit_(StatementAstNodePtr);
 	void Emit_(SequenceAstNodePtr);
 	void Emit_(LetAstNodePtr);
+	void Emit_(DimAstNodePtr);
 	void Emit_(InputAstNodePtr);
 	void Emit_(PrintAstNodePtr);
 	void Emit_(IfAstNodePtr);
+	/// С проверкой индексов цикл, обращения которого к массивам проверяются
+	/// перед ним (см. CollectLoopAccesses), генерируется в двух версиях:
+	/// без этих проверок, если они прошли, и со всеми проверками.
+	/// Вложенные в такой цикл циклы на версии не делятся
 	void Emit_(ForAstNodePtr);
+	/// Цикл FOR с целочисленным счётчиком и вычисленными началом, границей и шагом
+	void EmitLoop_(ForAstNodePtr, llvm::Value* begin, llvm::Value* end, llvm::Value* step);
+	/// @brief Цикл FOR с нецелочисленным счётчиком
+	///
+	/// Счётчик на k-й итерации равен begin + k * step, поэтому ошибки
+	/// округления шага не накапливаются. Значение, которое присвоит счётчику
+	/// тело, становится новым begin. Если тело не присваивает счётчику,
+	/// число итераций вычисляется до цикла, и LLVM может развернуть
+	/// и векторизовать цикл; оно совпадает с числом проверок counter < end.
+	void EmitNumericLoop_(ForAstNodePtr, llvm::Value* begin, llvm::Value* end, llvm::Value* step);
 	void Emit_(WhileAstNodePtr);
 	void Emit_(CallAstNodePtr);
 
@@ -55,23 +111,118 @@ private:
 	llvm::Value* Emit_(TextAstNodePtr);
 	llvm::Constant* Emit_(NumberAstNodePtr);
 	llvm::Constant* Emit_(BooleanAstNodePtr);
-	llvm::UnaryInstruction* Emit_(VariableAstNodePtr);
+	llvm::Value* Emit_(VariableAstNodePtr);
 	llvm::Value* Emit_(ItemAstNodePtr);
 
+	/// Значение выражения, целочисленного по integers_, в i64
+	llvm::Value* EmitInteger_(ExpressionAstNodePtr);
+	/// Индекс элемента массива, начиная с нуля
+	llvm::Value* EmitIndex_(ExpressionAstNodePtr);
+	/// Адрес первого элемента массива; у массива переменного размера — из дескриптора
+	llvm::Value* EmitArray_(VariableAstNodePtr array);
+	/// @brief Адрес элемента @p array с индексом @p index
+	///
+	/// С is_bounds_checking_ индекс вне массива вызывает bsq_index_out_of_range.
+	/// Проверка не создаётся, если integers_ доказывает, что индекс лежит
+	/// в пределах массива постоянного размера; проверки в циклах по массивам
+	/// переменного размера выносит из цикла IRCE, см. CompileOptions.
+	llvm::Value* EmitElement_(VariableAstNodePtr array, ExpressionAstNodePtr index);
+	/// Размер массива в DIM и REDIM в i64
+	llvm::Value* EmitSize_(ExpressionAstNodePtr);
+	/// @brief Целая граница целочисленного счётчика FOR для границы @p end в double
+	///
+	/// Для целого i условие i < end равносильно i < ceil(end), а i > end —
+	/// i > floor(end). Граница ограничивается ±IntegerInference::kLoopLimit,
+	/// NaN — значением, при котором цикл не выполняется, как и с fcmp.
+	llvm::Value* CreateLoopLimit_(llvm::Value* end, bool is_ascending);
+	/// Помечает переход в начало цикла FOR, счётчику которого тело
+	/// не присваивает, как llvm.loop.mustprogress: такой цикл конечен
+	void MarkLoopMustProgress_(llvm::BranchInst* latch);
+	/// Бинарная операция над INTEGER; '/' и '^' вычисляются в double
+	llvm::Value* CreateIntegerOperation_(Operation operation, llvm::Value* lhs, llvm::Value* rhs);
+	/// Индекс не выходит за массив постоянного размера по integers_
+	bool IsInBounds_(VariableAstNodePtr array, ExpressionAstNodePtr index) const;
+	/// @brief Условие, что индексы @p accesses в пределах своих массивов,
+	/// пока счётчик пробегает [@p first, @p last]
+	///
+	/// nullptr, если проверять нечего. Пустой промежуток может не пройти
+	/// проверку: цикл тогда не выполняется ни в одной из версий.
+	llvm::Value* CreateLoopBoundsCheck_(const std::vector<LoopAccess>& accesses, llvm::Value* first, llvm::Value* last);
+	/// @brief Переход к вызову @p function_name, если @p is_failed
+	///
+	/// Функция библиотеки сообщает об ошибке и завершает программу; ветвь
+	/// ошибки помечается холодной. Генерация продолжается в новом блоке.
+	void CreateErrorCheck_(llvm::Value* is_failed, std::string_view function_name, const llvm::ArrayRef<llvm::Value*>& arguments);
+	/// @brief Целочисленное деление или остаток
+	///
+	/// Деление на ноль прерывает программу вызовом bsq_division_by_zero.
+	llvm::Value* CreateIntegerDivision_(Operation operation, llvm::Value* lhs, llvm::Value* rhs);
+	/// @brief Память под локальный массив, выровненная по kArrayAlignment
+	///
+	/// Массив до kStackArrayLimit байтов размещается на стеке, больший —
+	/// в куче через bsq_array_alloc и освобождается при выходе из подпрограммы.
+	/// Для массива переменного размера создаётся пустой дескриптор ArrayType_,
+	/// память под элементы выделяют DIM и REDIM.
+	llvm::Value* CreateArray_(VariableAstNodePtr array);
+
 	llvm::Type* ToLlvmType_(DataType type);
 	llvm::Type* ToLlvmType_(std::string_view name);
 
 	/// Определяет позицию следующего BB
 	void SetCurrentBlock_(llvm::Function*, llvm::BasicBlock*);
 
+	/// Присваивает значение переменной: в SSA или в память
+	void AssignVariable_(std::string_view name, llvm::Value* value);
+	bool IsSsaVariable_(std::string_view name) const;
+
+	/// @brief Построение SSA для скалярных переменных
+	///
+	/// Числовые и логические переменные, кроме массивов, не хранятся
+	/// в памяти: значение переменной в конце каждого блока запоминается,
+	/// а на слияниях путей создаются φ-функции (M. Braun и др., Simple
+	/// and Efficient Construction of Static Single Assignment Form).
+	/// Блок запечатывается SealBlock_, когда известны все его
+	/// предшественники; до этого φ-функции его чтений остаются без операндов.
+	void WriteVariable_(std::string_view name, llvm::BasicBlock* block, llvm::Value* value);
+	llvm::Value* ReadVariable_(std::string_view name, llvm::BasicBlock* block);
+	llvm::Value* ReadVariableRecursive_(std::string_view name, llvm::BasicBlock* block);
+	llvm::Value* AddPhiOperands_(std::string_view name, llvm::PHINode* phi);
+	/// Заменяет φ-функцию, все операнды которой — одно значение или она сама
+	llvm::Value* TryRemoveTrivialPhi_(llvm::PHINode* phi);
+	void SealBlock_(llvm::BasicBlock* block);
+
 	void PrepareLibrary_();
 	void DeclareLibraryFunction_(std::string_view name, std::string_view signature);
 	llvm::FunctionCallee LibraryFunction_(std::string_view name);
-	llvm::FunctionCallee UserFunction_(std::string_view name);
+	llvm::FunctionCallee UserFunction_(SubroutineAstNodePtr);
 
 	void CreateEntryPoint_();
 	void DeclareSubroutines_(ProgramAstNodePtr);
+	llvm::Function* DeclareSubroutine_(SubroutineAstNodePtr);
 	void DefineSubroutines_(ProgramAstNodePtr);
+	/// Определяет подпрограммы program->subroutines[first, last)
+	void DefineSubroutines_(ProgramAstNodePtr, size_t first, size_t last);
+
+	/// @brief Генерирует пакеты в собственном LLVMContext, каждый в своём модуле
+	///
+	/// Безопасно вызывать одновременно для разных пакетов.
+	static void EmitBatches_(ProgramAstNodePtr, const std::vector<Batch*>& batches, bool is_bounds_checking);
+
+	/// @brief Собирает модуль программы из пакетов
+	///
+	/// Возвращает false, если какой-либо пакет не сгенерирован.
+	bool LinkBatches_(ProgramAstNodePtr, const std::vector<Batch>& batches);
+
+	/// @brief Переносит в модуль через @p mover модуль пакета, записанный в @p bitcode
+	///
+	/// В @p functions дописываются библиотечные функции, а в @p texts —
+	/// содержимое строковых констант пакета в порядке первого использования.
+	void LinkBatch_(llvm::IRMover& mover, llvm::StringRef bitcode, std::vector<std::string>& functions, std::vector<llvm::Constant*>& texts);
+
+	/// Восстанавливает порядок функций и строковых констант и имена констант
+	/// такими, какими их создаёт последовательная генерация
+	void RestoreOrder_(ProgramAstNodePtr, const std::vector<std::string>& functions, const std::vector<llvm::Constant*>& texts);
+
 	bool NeedCreateTemporaryText_(ExpressionAstNodePtr expression);
 	llvm::CallInst* CreateLibraryFunctionCall_(std::string_view function_name, const llvm::ArrayRef<llvm::Value*>& args);
 
@@ -81,15 +232,34 @@ private:
 
 	ProgramAstNodePtr program_;
 	llvm::Module& module_;
+	bool is_bounds_checking_;
 
 	std::unordered_map<std::string, llvm::FunctionType*> library_functions_;
-	std::unordered_map<std::string, llvm::Value*> textual_constants_;
-	std::unordered_map<std::string, llvm::Value*> variable_addresses_;
+	// ключи — строки из арены программы
+	std::unordered_map<std::string_view, llvm::Value*> textual_constants_;
+	std::unordered_map<std::string_view, llvm::Value*> variable_addresses_;
+
+	/// Типы переменных подпрограммы, значения которых строятся в SSA
+	std::unordered_map<std::string_view, llvm::Type*> ssa_variables_;
+	/// Значения переменных в конце блоков; следуют за replaceAllUsesWith
+	std::unordered_map<llvm::BasicBlock*, std::unordered_map<std::string_view, llvm::WeakTrackingVH>> current_definitions_;
+	/// φ-функции незапечатанных блоков, операнды которых ещё не добавлены
+	std::unordered_map<llvm::BasicBlock*, std::vector<std::pair<std::string_view, llvm::PHINode*>>> incomplete_phis_;
+	std::unordered_set<llvm::BasicBlock*> sealed_blocks_;
+	/// Целочисленные переменные и выражения подпрограммы; переменные хранятся в i64
+	std::optional<IntegerInference> integers_;
+	/// Индексы, которые проверены перед циклом, см. Emit_(ForAstNodePtr)
+	std::unordered_set<ExpressionAstNodePtr> in_bounds_indices_;
+	/// Генерируется одна из версий цикла; вложенные циклы не делятся на версии
+	bool is_in_versioned_loop_ = false;
 
 	llvm::Type* VoidType_ = ir_builder_.getVoidTy();
 	llvm::Type* BooleanType_ = ir_builder_.getInt1Ty();
 	llvm::Type* NumericType_ = ir_builder_.getDoubleTy();
+	llvm::Type* IntegerType_ = ir_builder_.getInt64Ty();
 	llvm::Type* TextualType_ = ir_builder_.getInt8PtrTy();
+	/// Дескриптор массива переменного размера: адрес элементов, длина и ёмкость
+	llvm::StructType* ArrayType_ = llvm::StructType::get(NumericType_->getPointerTo(), IntegerType_, IntegerType_);
 };
 
 }  // namespace bsq
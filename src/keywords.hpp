@@ -0,0 +1,67 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <string_view>
+
+#include "lexeme.hpp"
+
+
+namespace bsq {
+
+struct Keyword {
+	std::string_view name;
+	Token token = Token::kIdentifier;
+};
+
+inline constexpr std::array<Keyword, 23> kKeywords = {{
+	{"SUB",    Token::kSubroutine},
+	{"LET",    Token::kLet},
+	{"DIM",    Token::kDim},
+	{"REDIM",  Token::kRedim},
+	{"PRESERVE", Token::kPreserve},
+	{"PRINT",  Token::kPrint},
+	{"INPUT",  Token::kInput},
+	{"IF",     Token::kIf},
+	{"THEN",   Token::kThen},
+	{"ELSEIF", Token::kElseIf},
+	{"ELSE",   Token::kElse},
+	{"WHILE",  Token::kWhile},
+	{"FOR",    Token::kFor},
+	{"TO",     Token::kTo},
+	{"STEP",   Token::kStep},
+	{"CALL",   Token::kCall},
+	{"END",    Token::kEnd},
+	{"MOD",    Token::kMod},
+	{"AND",    Token::kAnd},
+	{"OR",     Token::kOr},
+	{"NOT",    Token::kNot},
+	{"TRUE",   Token::kTrue},
+	{"FALSE",  Token::kFalse},
+}};
+
+inline constexpr std::size_t kKeywordTableSize = 64;
+
+/// Совершенная хеш-функция для kKeywords: длина, первый и последний символы
+[[nodiscard]] constexpr std::size_t KeywordHash(std::string_view word) {
+	const auto first = static_cast<unsigned char>(word.front());
+	const auto last = static_cast<unsigned char>(word.back());
+	return (word.size() * 6 + first + last * 6) % kKeywordTableSize;
+}
+
+/// kKeywords, разложенные по KeywordHash; пустые ячейки — IDENT
+inline constexpr auto kKeywordTable = [] {
+	std::array<Keyword, kKeywordTableSize> table{};
+	for (const auto& keyword : kKeywords) {
+		table[KeywordHash(keyword.name)] = keyword;
+	}
+	return table;
+}();
+
+/// Ключевое слово или IDENT: одно вычисление хеша и одно сравнение строк
+[[nodiscard]] constexpr Token ClassifyWord(std::string_view word) {
+	const auto& candidate = kKeywordTable[KeywordHash(word)];
+	return candidate.name == word ? candidate.token : Token::kIdentifier;
+}
+
+}  // namespace bsq
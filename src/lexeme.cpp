@@ -16,6 +16,8 @@ std::string ToString(Token token) {
 	case Token::kPrint: return "PRINT";
 	case Token::kLet: return "LET";
 	case Token::kDim: return "DIM";
+	case Token::kRedim: return "REDIM";
+	case Token::kPreserve: return "PRESERVE";
 	case Token::kIf: return "IF";
 	case Token::kThen: return "THEN";
 	case Token::kElseIf: return "ELSEIF";
@@ -42,6 +44,7 @@ std::string ToString(Token token) {
 	case Token::kOr: return "OR";
 	case Token::kMul: return "*";
 	case Token::kDiv: return "/";
+	case Token::kIntDiv: return "\\";
 	case Token::kMod: return "MOD";
 	case Token::kAnd: return "AND";
 	case Token::kPow: return "^";
@@ -50,17 +53,4 @@ std::string ToString(Token token) {
 	}
 }
 
-bool Lexeme::OfType(Token exp) const {
-	return exp == token;
-}
-
-bool Lexeme::OfTypeIn(const std::vector<Token>& tokens) const {
-	for (auto tok : tokens) {
-		if (token == tok) {
-			return true;
-		}
-	}
-	return false;
-}
-
 }  // namespace bsq
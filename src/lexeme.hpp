@@ -1,13 +1,14 @@
 ﻿#pragma once
 
+#include <cstdint>
+#include <initializer_list>
 #include <string>
 #include <string_view>
-#include <vector>
 
 
 namespace bsq {
 
-enum class Token {
+enum class Token : std::uint8_t {
 	kNone,
 
 	kNumber,
@@ -21,6 +22,8 @@ enum class Token {
 	kPrint,
 	kLet,
 	kDim,
+	kRedim,
+	kPreserve,
 	kIf,
 	kThen,
 	kElseIf,
@@ -51,6 +54,7 @@ enum class Token {
 	kOr,
 	kMul,
 	kDiv,
+	kIntDiv,
 	kMod,
 	kAnd,
 	kPow,
@@ -62,12 +66,32 @@ enum class Token {
 std::string ToString(Token token);
 
 
+/// Множество видов лексем в виде битовой маски
+class TokenSet {
+public:
+	constexpr TokenSet(std::initializer_list<Token> tokens) {
+		for (auto token : tokens) {
+			bits_ |= Bit_(token);
+		}
+	}
+
+	[[nodiscard]] constexpr bool Contains(Token token) const { return (bits_ & Bit_(token)) != 0; }
+
+private:
+	static constexpr std::uint64_t Bit_(Token token) { return std::uint64_t{1} << static_cast<unsigned>(token); }
+
+	std::uint64_t bits_ = 0;
+};
+
+static_assert(static_cast<unsigned>(Token::kEof) < 64, "TokenSet не вмещает все виды лексем");
+
+
 struct Lexeme {
 	Token token = Token::kNone;
-	std::string value;
+	std::string_view value;  ///< Срез исходного текста
 
-	[[nodiscard]] bool OfType(Token exp) const;
-	[[nodiscard]] bool OfTypeIn(const std::vector<Token>& exps) const;
+	[[nodiscard]] bool OfType(Token exp) const { return exp == token; }
+	[[nodiscard]] bool OfTypeIn(TokenSet exps) const { return exps.Contains(token); }
 };
 
 }  // namespace bsq
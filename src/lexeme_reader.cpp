@@ -1,124 +1,224 @@
 #include "lexeme_reader.hpp"
 
-#include <cctype>
-#include <string>
+#include <cstddef>
+#include <cstring>
+#include <utility>
+#include <vector>
 
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/ThreadPool.h>
 
-namespace bsq {
+#include "char_scanner.hpp"
+#include "keywords.hpp"
+#include "trace.hpp"
 
-std::map<std::string_view, Token> LexemeReader::keywords_ = {
-	{"SUB",    Token::kSubroutine},
-	{"LET",    Token::kLet},
-	{"DIM",    Token::kDim},
-	{"PRINT",  Token::kPrint},
-	{"INPUT",  Token::kInput},
-	{"IF",     Token::kIf},
-	{"THEN",   Token::kThen},
-	{"ELSEIF", Token::kElseIf},
-	{"ELSE",   Token::kElse},
-	{"WHILE",  Token::kWhile},
-	{"FOR",    Token::kFor},
-	{"TO",     Token::kTo},
-	{"STEP",   Token::kStep},
-	{"CALL",   Token::kCall},
-	{"END",    Token::kEnd},
-	{"MOD",    Token::kMod},
-	{"AND",    Token::kAnd},
-	{"OR",     Token::kOr},
-	{"NOT",    Token::kNot},
-	{"TRUE",   Token::kTrue},
-	{"FALSE",  Token::kFalse},
-};
 
-LexemeReader::LexemeReader(const std::filesystem::path& filename) {
-	input_.open(filename);
-	input_.unsetf(std::ios_base::skipws);
-	input_ >> current_char_;
+namespace {
+
+/// Частей текста больше, чем потоков, чтобы выровнять нагрузку
+constexpr std::size_t kPartsPerThread = 4;
+
+constexpr bool sIsKeywordHashPerfect() {
+	for (const auto& keyword : bsq::kKeywords) {
+		if (bsq::kKeywordTable[bsq::KeywordHash(keyword.name)].name != keyword.name) {
+			return false;
+		}
+	}
+	return true;
 }
 
-LexemeReader::~LexemeReader() {
-	if (input_.is_open()) {
-		input_.close();
+static_assert(sIsKeywordHashPerfect(), "KeywordHash даёт коллизии на kKeywords");
+
+static_assert(bsq::ClassifyWord("ELSEIF") == bsq::Token::kElseIf);
+static_assert(bsq::ClassifyWord("ELSE") == bsq::Token::kElse);
+static_assert(bsq::ClassifyWord("END$") == bsq::Token::kIdentifier);
+
+}  // namespace
+
+
+namespace bsq {
+
+LexemeReader::LexemeReader(const std::filesystem::path& filename) {
+	// Большие файлы отображаются в память (mmap), маленькие — читаются целиком
+	auto file = llvm::MemoryBuffer::getFile(filename.string(), false, false);
+	if (file) {
+		file_ = std::move(file.get());
+		begin_ = file_->getBufferStart();
+		current_ = begin_;
+		end_ = file_->getBufferEnd();
 	}
 }
 
+LexemeReader::LexemeReader(std::string_view source)
+	: begin_{source.data()}
+	, current_{source.data()}
+	, end_{source.data() + source.size()}
+{
+}
+
+LexemeReader::~LexemeReader() = default;
+
 LexemeReader& LexemeReader::operator>>(Lexeme& lexeme) {
 	ReadNext_(lexeme);
 	return *this;
 }
 
+TokenBuffer LexemeReader::Tokenize() {
+	TRACE(Lex);
+
+	TokenBuffer tokens{{begin_, static_cast<std::size_t>(end_ - begin_)}};
+
+	Lexeme lexeme;
+	do {
+		const auto line = line_;
+		ReadNext_(lexeme);
+		tokens.Append(lexeme, line);
+	} while (!lexeme.OfType(Token::kEof));
+
+	return tokens;
+}
+
+TokenBuffer LexemeReader::Tokenize(llvm::ThreadPool& pool) {
+	TRACE(Lex);
+
+	// Части начинаются с начала строки. Состояние анализатора в начале
+	// строки — только номер строки, поэтому части читаются независимо,
+	// если ни одна лексема не пересекает границу частей. Пересечь её может
+	// лишь текстовая константа с переводом строки; тогда текст читается
+	// целиком одним потоком.
+	const auto part_count = static_cast<std::size_t>(pool.getThreadCount()) * kPartsPerThread;
+	const auto part_size = static_cast<std::size_t>(end_ - current_) / part_count + 1;
+
+	std::vector<const char*> bounds{current_};
+	while (static_cast<std::size_t>(end_ - bounds.back()) > part_size) {
+		const char* middle = bounds.back() + part_size;
+		const auto* new_line = static_cast<const char*>(std::memchr(middle, '\n', static_cast<std::size_t>(end_ - middle)));
+		if (new_line == nullptr) {
+			break;
+		}
+		bounds.push_back(new_line + 1);
+	}
+	if (bounds.back() != end_) {
+		bounds.push_back(end_);
+	}
+
+	std::vector<TokenBuffer> parts(bounds.size() - 1);
+	for (std::size_t i = 0; i < parts.size(); ++i) {
+		pool.async([&parts, &bounds, i] {
+			TraceThread trace_thread;
+			parts[i] = LexemeReader{std::string_view{bounds[i], static_cast<std::size_t>(bounds[i + 1] - bounds[i])}}.Tokenize();
+		});
+	}
+	pool.wait();
+
+	// каждая часть, кроме последней, должна заканчиваться своим переводом строки
+	for (std::size_t i = 0; i + 1 < parts.size(); ++i) {
+		const auto& part = parts[i];
+		if (part.Size() < 2 || part.GetToken(part.Size() - 2) != Token::kNewLine
+			|| part.GetValue(part.Size() - 2).data() + 1 != bounds[i + 1]) {
+			return Tokenize();
+		}
+	}
+
+	// Сначала вычисляются места частей в общем буфере, затем части
+	// копируются в него одновременно
+	std::vector<std::size_t> indices(parts.size());
+	std::vector<std::uint32_t> line_offsets(parts.size());
+	std::size_t size = 0;
+	std::uint32_t line_offset = line_ - 1;
+	for (std::size_t i = 0; i < parts.size(); ++i) {
+		indices[i] = size;
+		line_offsets[i] = line_offset;
+		size += parts[i].Size() - 1;
+		line_offset += parts[i].GetLine(parts[i].Size() - 1) - 1;
+	}
+
+	TokenBuffer tokens{{begin_, static_cast<std::size_t>(end_ - begin_)}};
+	tokens.Reserve(size + 1);  // с местом для Eof
+	tokens.Resize(size);
+	for (std::size_t i = 0; i < parts.size(); ++i) {
+		pool.async([&tokens, &parts, &indices, &line_offsets, i] {
+			TraceThread trace_thread;
+			tokens.Assign(indices[i], parts[i], line_offsets[i]);
+			parts[i] = TokenBuffer{};
+		});
+	}
+	pool.wait();
+
+	current_ = end_;
+	line_ = line_offset + 1;
+	tokens.Append({Token::kEof, {}}, line_);
+
+	return tokens;
+}
+
 bool LexemeReader::ReadNext_(Lexeme& lexeme) {
 	lexeme.token = Token::kNone;
-	lexeme.value = "";
+	lexeme.value = {};
 
-	while (current_char_ == ' ' || current_char_ == '\t' || current_char_ == '\r') {
-		input_ >> current_char_;
-	}
+	current_ = SkipBlanks(current_, end_);
 
-	if (input_.eof()) {
+	if (IsEof_()) {
 		lexeme.token = Token::kEof;
 		lexeme.value = "EOF";
 		return true;
 	}
 
-	if (std::isdigit(current_char_)) {
+	const char current_char = *current_;
+
+	if (IsDigit(current_char)) {
 		return ReadNumber_(lexeme);
 	}
 
-	if (current_char_ == '"') {
+	if (current_char == '"') {
 		return ReadText_(lexeme);
 	}
 
-	if (std::isalpha(current_char_)) {
+	if (IsAlpha(current_char)) {
 		return ReadIdentifier_(lexeme);
 	}
 
 	// Однострочный комментарий
-	if (current_char_ == '\'') {
-		while (current_char_ != '\n') {
-			input_ >> current_char_;
-		}
+	if (current_char == '\'') {
+		current_ = SkipLine(current_, end_);
 		return ReadNext_(lexeme);
 	}
 
-	if (current_char_ == '\n') {
+	const char* begin = current_++;
+
+	if (current_char == '\n') {
 		lexeme.token = Token::kNewLine;
-		lexeme.value = "\n";
-		input_ >> current_char_;
+		lexeme.value = {begin, current_};
+		++line_;
 		return true;
 	}
 
-	if (current_char_ == '<') {
-		lexeme.value = "<";
-		input_ >> current_char_;
-		if (current_char_ == '>') {
-			lexeme.value.push_back('>');
-			input_ >> current_char_;
+	if (current_char == '<') {
+		if (Peek_() == '>') {
+			++current_;
 			lexeme.token = Token::kNe;
-		} else if (current_char_ == '=') {
-			lexeme.value.push_back('=');
-			input_ >> current_char_;
+		} else if (Peek_() == '=') {
+			++current_;
 			lexeme.token = Token::kLe;
 		} else {
 			lexeme.token = Token::kLt;
 		}
+		lexeme.value = {begin, current_};
 		return true;
 	}
 
-	if (current_char_ == '>') {
-		lexeme.value = ">";
-		input_ >> current_char_;
-		if (current_char_ == '=') {
-			lexeme.value.push_back('=');
-			input_ >> current_char_;
+	if (current_char == '>') {
+		if (Peek_() == '=') {
+			++current_;
 			lexeme.token = Token::kGe;
 		} else {
 			lexeme.token = Token::kGt;
 		}
+		lexeme.value = {begin, current_};
 		return true;
 	}
 
-	switch (current_char_) {
+	switch (current_char) {
 	case '(':
 		lexeme.token = Token::kLeftPar;
 		break;
@@ -140,6 +240,9 @@ bool LexemeReader::ReadNext_(Lexeme& lexeme) {
 	case '/':
 		lexeme.token = Token::kDiv;
 		break;
+	case '\\':
+		lexeme.token = Token::kIntDiv;
+		break;
 	case '^':
 		lexeme.token = Token::kPow;
 		break;
@@ -151,53 +254,50 @@ bool LexemeReader::ReadNext_(Lexeme& lexeme) {
 		break;
 	};
 
-	input_ >> current_char_;
+	lexeme.value = {begin, current_};
 
 	return lexeme.token != Token::kNone;
 }
 
 bool LexemeReader::ReadNumber_(Lexeme& lexeme) {
-	while (std::isdigit(current_char_)) {
-		lexeme.value.push_back(current_char_);
-		input_ >> current_char_;
-	}
+	const char* begin = current_;
 
-	if (current_char_ == '.') {
-		lexeme.value.push_back('.');
-		input_ >> current_char_;
-		while (std::isdigit(current_char_)) {
-			lexeme.value.push_back(current_char_);
-			input_ >> current_char_;
-		}
+	current_ = SkipDigits(current_, end_);
+
+	if (Peek_() == '.') {
+		current_ = SkipDigits(current_ + 1, end_);
 	}
+
+	lexeme.value = {begin, current_};
 	lexeme.token = Token::kNumber;
 	return true;
 }
 
 bool LexemeReader::ReadText_(Lexeme& lexeme) {
-	input_ >> current_char_;
-	while (current_char_ != '"') {
-		lexeme.value.push_back(current_char_);
-		input_ >> current_char_;
+	const char* begin = ++current_;
+	while (!IsEof_() && *current_ != '"') {
+		++current_;
+	}
+	lexeme.value = {begin, current_};
+	if (!IsEof_()) {
+		++current_;
 	}
-	input_ >> current_char_;
 	lexeme.token = Token::kText;
 	return true;
 }
 
 bool LexemeReader::ReadIdentifier_(Lexeme& lexeme) {
-	while (std::isalnum(current_char_)) {
-		lexeme.value.push_back(current_char_);
-		input_ >> current_char_;
-	}
+	const char* begin = current_;
+
+	current_ = SkipAlnums(current_, end_);
 
-	if (current_char_ == '$' || current_char_ == '?') {
-		lexeme.value.push_back(current_char_);
-		input_ >> current_char_;
+	if (Peek_() == '$' || Peek_() == '?' || Peek_() == '%') {
+		++current_;
 	}
 
-	auto keyword_it = keywords_.find(lexeme.value);
-	lexeme.token = keyword_it == keywords_.end() ? Token::kIdentifier : keyword_it->second;
+	lexeme.value = {begin, current_};
+
+	lexeme.token = ClassifyWord(lexeme.value);
 
 	return true;
 }
@@ -1,27 +1,62 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
 #include <filesystem>
-#include <fstream>
-#include <map>
+#include <memory>
 #include <string_view>
 
 #include "lexeme.hpp"
+#include "token_buffer.hpp"
+
+
+namespace llvm {
+
+class MemoryBuffer;
+class ThreadPool;
+
+}  // namespace llvm
 
 
 namespace bsq {
 
+/// @brief Лексический анализатор
+///
+/// Работает с исходным текстом целиком: файл отображается в память,
+/// а значения лексем — срезы этого буфера, поэтому чтение лексемы
+/// не копирует символы и не выделяет память.
 class LexemeReader {
 public:
 	explicit LexemeReader(const std::filesystem::path& filename);
+
+	/// Буфер @p source должен жить дольше анализатора и прочитанных лексем
+	explicit LexemeReader(std::string_view source);
+
 	~LexemeReader();
 
 	LexemeReader& operator>>(Lexeme& lexeme);
 
+	/// Размер исходного текста в байтах
+	[[nodiscard]] std::size_t GetSize() const { return static_cast<std::size_t>(end_ - begin_); }
+
+	/// Читает все оставшиеся лексемы до Eof включительно
+	TokenBuffer Tokenize();
+
+	/// То же, что Tokenize(), но текст делится на части по границам строк,
+	/// и части читаются одновременно потоками @p pool
+	TokenBuffer Tokenize(llvm::ThreadPool& pool);
+
 private:
-	std::ifstream input_;
-	char current_char_ = '\0';
+	std::unique_ptr<llvm::MemoryBuffer> file_;
+
+	const char* begin_ = nullptr;
+	const char* current_ = nullptr;
+	const char* end_ = nullptr;
+
+	std::uint32_t line_ = 1;  ///< Номер строки текущего символа
 
-	static std::map<std::string_view, Token> keywords_;
+	[[nodiscard]] char Peek_() const { return current_ != end_ ? *current_ : '\0'; }
+	[[nodiscard]] bool IsEof_() const { return current_ == end_; }
 
 	bool ReadNext_(Lexeme& lexeme);
 	bool ReadNumber_(Lexeme& lexeme);
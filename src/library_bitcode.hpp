@@ -0,0 +1,13 @@
+#pragma once
+
+#include <cstddef>
+
+
+namespace bsq {
+
+/// bitcode библиотеки времени выполнения (bsq_lib.c), встроенный
+/// в компилятор при сборке, см. cmake/embed_file.cmake
+extern const unsigned char kLibraryBitcode[];
+extern const std::size_t kLibraryBitcodeSize;
+
+}  // namespace bsq
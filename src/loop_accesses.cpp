@@ -0,0 +1,192 @@
+#include "loop_accesses.hpp"
+
+#include <cmath>
+#include <optional>
+#include <string_view>
+#include <unordered_set>
+#include <utility>
+
+
+namespace {
+
+using namespace bsq;
+
+/// Наибольшее по модулю смещение индекса: с ним проверки перед циклом
+/// не переполняются
+constexpr double kOffsetLimit = 4294967296.0;  // 2^32
+
+/// Обходит тело цикла и собирает обращения к массивам
+class LoopAccessCollector {
+public:
+	explicit LoopAccessCollector(std::string_view counter)
+		: counter_{counter}
+	{
+	}
+
+	void Collect(StatementAstNodePtr node) {
+		if (node != nullptr) {
+			VisitStatement(node, *this);
+		}
+	}
+
+	void Collect(ExpressionAstNodePtr node) {
+		if (node != nullptr) {
+			VisitExpression(node, *this);
+		}
+	}
+
+	bool IsCounterAssigned() const { return is_counter_assigned_; }
+
+	std::vector<LoopAccess> GetAccesses() const {
+		if (is_counter_assigned_) {
+			return {};
+		}
+
+		auto accesses = accesses_;
+		std::erase_if(accesses, [this](const LoopAccess& access) { return resized_arrays_.contains(access.array->GetName()); });
+		return accesses;
+	}
+
+	void operator()(SequenceAstNodePtr node) {
+		for (auto* item : node->items) {
+			Collect(item);
+		}
+	}
+
+	void operator()(InputAstNodePtr node) {
+		if (node->item == nullptr) {
+			Assign_(node->variable);
+		}
+		Collect(node->prompt);
+		Collect(node->item);
+	}
+
+	void operator()(PrintAstNodePtr node) { Collect(node->expression); }
+
+	void operator()(LetAstNodePtr node) {
+		Collect(node->expression);
+		if (node->array_index != nullptr) {
+			Access_(node->variable, node->array_index);
+			Collect(node->array_index);
+		} else {
+			Assign_(node->variable);
+		}
+	}
+
+	void operator()(DimAstNodePtr node) {
+		resized_arrays_.insert(node->variable->GetName());
+		Collect(node->size);
+	}
+
+	void operator()(IfAstNodePtr node) {
+		Collect(node->condition);
+		Collect(node->then);
+		Collect(node->otherwise);
+	}
+
+	void operator()(WhileAstNodePtr node) {
+		Collect(node->condition);
+		Collect(node->body);
+	}
+
+	void operator()(ForAstNodePtr node) {
+		Assign_(node->variable);
+		Collect(node->begin);
+		Collect(node->end);
+		Collect(node->body);
+	}
+
+	void operator()(CallAstNodePtr node) { Collect(node->subroutine_call); }
+
+	void operator()(ItemAstNodePtr node) {
+		Access_(node->array, node->expression);
+		Collect(node->expression);
+	}
+
+	void operator()(UnaryExpressionAstNodePtr node) { Collect(node->GetOperand()); }
+
+	void operator()(BinaryExpressionAstNodePtr node) {
+		Collect(node->GetLeftOperand());
+		Collect(node->GetRightOperand());
+	}
+
+	void operator()(ApplyAstNodePtr node) {
+		for (auto* argument : node->GetArguments()) {
+			Collect(argument);
+		}
+	}
+
+	/// Листья: константы и переменные
+	template <typename T>
+	void operator()(T*) {}
+
+private:
+	void Assign_(VariableAstNodePtr variable) {
+		is_counter_assigned_ = is_counter_assigned_ || variable->GetName() == counter_;
+	}
+
+	void Access_(VariableAstNodePtr array, ExpressionAstNodePtr index) {
+		if (const auto offset = GetOffset_(index)) {
+			accesses_.push_back({array, index, *offset});
+		}
+	}
+
+	/// c в индексе i + c, c + i или i - c; 0 в индексе i
+	std::optional<std::int64_t> GetOffset_(ExpressionAstNodePtr index) const {
+		if (IsCounter_(index)) {
+			return 0;
+		}
+
+		auto* binary = AstNodeCast<BinaryExpressionAstNode>(index);
+		if (binary == nullptr) {
+			return std::nullopt;
+		}
+
+		const auto operation = binary->GetOperation();
+		auto* lhs = binary->GetLeftOperand();
+		auto* rhs = binary->GetRightOperand();
+		if (Operation::kAdd == operation && IsCounter_(rhs)) {
+			std::swap(lhs, rhs);
+		}
+		if ((Operation::kAdd != operation && Operation::kSub != operation) || !IsCounter_(lhs)) {
+			return std::nullopt;
+		}
+
+		const auto* number = AstNodeCast<NumberAstNode>(rhs);
+		if (number == nullptr || !number->IsIntegral() || std::fabs(number->GetValue()) > kOffsetLimit) {
+			return std::nullopt;
+		}
+		const auto offset = number->GetIntegerValue();
+		return Operation::kAdd == operation ? offset : -offset;
+	}
+
+	bool IsCounter_(ExpressionAstNodePtr expression) const {
+		const auto* variable = AstNodeCast<VariableAstNode>(expression);
+		return variable != nullptr && variable->GetName() == counter_;
+	}
+
+private:
+	std::string_view counter_;
+	bool is_counter_assigned_ = false;
+	std::vector<LoopAccess> accesses_;
+	std::unordered_set<std::string_view> resized_arrays_;
+};
+
+}  // namespace
+
+
+namespace bsq {
+
+std::vector<LoopAccess> CollectLoopAccesses(ForAstNodePtr for_node) {
+	LoopAccessCollector collector{for_node->variable->GetName()};
+	collector.Collect(for_node->body);
+	return collector.GetAccesses();
+}
+
+bool AssignsCounter(ForAstNodePtr for_node) {
+	LoopAccessCollector collector{for_node->variable->GetName()};
+	collector.Collect(for_node->body);
+	return collector.IsCounterAssigned();
+}
+
+}  // namespace bsq
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "ast.hpp"
+
+
+namespace bsq {
+
+/// Обращение к элементу массива с индексом «счётчик цикла + offset»
+struct LoopAccess {
+	VariableAstNodePtr array;
+	ExpressionAstNodePtr index;
+	std::int64_t offset = 0;
+};
+
+/// @brief Обращения к массивам в теле @p for_node с индексом i, i + c,
+/// c + i или i - c, где i — счётчик цикла, а c — целая константа
+///
+/// Если тело не меняет ни счётчик, ни размер массива, индексы таких
+/// обращений пробегают известный перед циклом промежуток, и проверку
+/// их всех можно сделать один раз, см. IrGenerator::Emit_(ForAstNodePtr).
+/// Результат пуст, если тело присваивает счётчику; обращения к массиву,
+/// который тело объявляет заново (DIM, REDIM), не включаются.
+std::vector<LoopAccess> CollectLoopAccesses(ForAstNodePtr for_node);
+
+/// Тело @p for_node присваивает счётчику: LET, INPUT или вложенный FOR
+bool AssignsCounter(ForAstNodePtr for_node);
+
+}  // namespace bsq
@@ -1,15 +1,27 @@
-#include <iostream>
+#include <string>
+#include <vector>
 
+#include "command_line.hpp"
 #include "compiler.hpp"
+#include "server.hpp"
 
 
 int main(int argc, char* argv[]) {
-	if (argc > 1) {
-		std::cout << bsq::Compile(argv[1]) << std::endl;
-		return 0;
+	const std::vector<std::string> arguments(argv + 1, argv + argc);
+	const auto command_line = bsq::ParseCommandLine(arguments);
+	if (!command_line.has_value()) {
+		return 1;
 	}
 
-	std::cout << bsq::Compile("../tests/bubble.bas");
+	if (command_line->serve_socket.has_value()) {
+		return bsq::Serve(*command_line->serve_socket);
+	}
+	if (command_line->server_socket.has_value()) {
+		return bsq::CompileOnServer(*command_line->server_socket, arguments);
+	}
+
+	bsq::CompilerPool compilers;
+	return bsq::RunCommandLine(*command_line, compilers);
 
 	/*const std::string prefix = "../tests/test";
 	for (size_t i = 0; i <= 17; ++i) {
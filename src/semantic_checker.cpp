@@ -5,6 +5,55 @@
 #include <string_view>
 #include <utility>
 
+#include "trace.hpp"
+
+
+namespace {
+
+using namespace bsq;
+
+/// @brief Может ли выражение стать INTEGER
+///
+/// Числовые литералы с целыми значениями и выражения из них через '+',
+/// '-', '*' и MOD не имеют собственного типа, пока его не задаст
+/// контекст: операнд INTEGER, целая переменная или параметр.
+bool sIsIntegerConstant(ExpressionAstNodePtr expression) {
+	if (const auto* number = AstNodeCast<NumberAstNode>(expression)) {
+		return number->IsIntegral();
+	}
+	if (auto* unary = AstNodeCast<UnaryExpressionAstNode>(expression)) {
+		return Operation::kSub == unary->GetOperation() && sIsIntegerConstant(unary->GetOperand());
+	}
+	if (auto* binary = AstNodeCast<BinaryExpressionAstNode>(expression)) {
+		const auto operation = binary->GetOperation();
+		const bool is_allowed =    operation == Operation::kAdd
+		                        || operation == Operation::kSub
+		                        || operation == Operation::kMul
+		                        || operation == Operation::kMod;
+		return is_allowed && sIsIntegerConstant(binary->GetLeftOperand()) && sIsIntegerConstant(binary->GetRightOperand());
+	}
+	return false;
+}
+
+void sMakeInteger(ExpressionAstNodePtr expression) {
+	expression->SetType(DataType::kInteger);
+	if (auto* unary = AstNodeCast<UnaryExpressionAstNode>(expression)) {
+		sMakeInteger(unary->GetOperand());
+	} else if (auto* binary = AstNodeCast<BinaryExpressionAstNode>(expression)) {
+		sMakeInteger(binary->GetLeftOperand());
+		sMakeInteger(binary->GetRightOperand());
+	}
+}
+
+/// Делает целой константу типа NUMBER; другие выражения не меняются
+void sCoerceToInteger(ExpressionAstNodePtr expression) {
+	if (expression->OfType(DataType::kNumeric) && sIsIntegerConstant(expression)) {
+		sMakeInteger(expression);
+	}
+}
+
+}  // namespace
+
 
 namespace bsq {
 
@@ -30,6 +79,8 @@ private:
 
 
 std::optional<std::string> SemanticChecker::Check(AstNodePtr node) {
+	TRACE(Check);
+
 	try {
 		visit(std::move(node));
 	}
@@ -74,6 +125,9 @@ void SemanticChecker::visit(LetAstNodePtr node) {
 		return;
 	}
 	visit(node->expression);
+	if (node->variable->OfType(DataType::kInteger)) {
+		sCoerceToInteger(node->expression);
+	}
 	if (node->expression->GetType() != node->variable->GetType()) {
 		throw TypeCheckError{
 			"Переменной типа " + ToString(node->variable->GetType()) +
@@ -83,13 +137,20 @@ void SemanticChecker::visit(LetAstNodePtr node) {
 }
 
 void SemanticChecker::visit(DimAstNodePtr node) {
-	if (node->size->GetValue() <= 0) {
-		throw TypeCheckError{"Размер массива должен быть натуральным числом"};
+	// размер, вычисляемый при выполнении, проверяет bsq_array_resize
+	if (const auto* number = AstNodeCast<NumberAstNode>(node->size)) {
+		if (number->GetValue() < 0 || !number->IsIntegral()) {
+			throw TypeCheckError{"Размер массива должен быть целым неотрицательным числом"};
+		}
+		if (static_cast<size_t>(number->GetIntegerValue()) > VariableAstNode::kMaxArraySize) {
+			throw TypeCheckError{"Размер массива больше " + std::to_string(VariableAstNode::kMaxArraySize)};
+		}
+		return;
 	}
-	node->variable->SetType(DataType::kArray);
-	node->variable->array_size = static_cast<size_t>(node->size->GetValue());
-	if (static_cast<double>(node->variable->array_size) != node->size->GetValue()) {
-		throw TypeCheckError{"Размер массива должен быть натуральным числом"};
+
+	visit(node->size);
+	if (node->size->NotOfType(DataType::kNumeric) && node->size->NotOfType(DataType::kInteger)) {
+		throw TypeCheckError{"Размер массива должен быть числовым"};
 	}
 }
 
@@ -125,26 +186,33 @@ void SemanticChecker::visit(WhileAstNodePtr node) {
 }
 
 void SemanticChecker::visit(ForAstNodePtr node) {
-	if (node->variable->NotOfType(DataType::kNumeric)) {
+	const auto type = node->variable->GetType();
+	if (type != DataType::kNumeric && type != DataType::kInteger) {
 		throw TypeCheckError{
 			"Тип переменной в цикле FOR — " + ToString(node->variable->GetType()) +
-			", а должен быть " + ToString(DataType::kNumeric)
+			", а должен быть " + ToString(DataType::kNumeric) + " или " + ToString(DataType::kInteger)
 		};
 	}
 
 	visit(node->begin);
-	if (node->begin->NotOfType(DataType::kNumeric)) {
+	if (type == DataType::kInteger) {
+		sCoerceToInteger(node->begin);
+	}
+	if (node->begin->NotOfType(type)) {
 		throw TypeCheckError{
 			"Тип начального значения переменной в цикле FOR — " + ToString(node->begin->GetType()) +
-			", а должен быть " + ToString(DataType::kNumeric)
+			", а должен быть " + ToString(type)
 		};
 	}
 
 	visit(node->end);
-	if (node->end->NotOfType(DataType::kNumeric)) {
+	if (type == DataType::kInteger) {
+		sCoerceToInteger(node->end);
+	}
+	if (node->end->NotOfType(type)) {
 		throw TypeCheckError{
 			"Тип конечного значения переменной в цикле FOR — " + ToString(node->begin->GetType()) +
-			", а должен быть " + ToString(DataType::kNumeric)
+			", а должен быть " + ToString(type)
 		};
 	}
 
@@ -152,6 +220,13 @@ void SemanticChecker::visit(ForAstNodePtr node) {
 		throw TypeCheckError("Шаг переменной в цикле FOR равен нулю");
 	}
 
+	if (type == DataType::kInteger) {
+		if (!sIsIntegerConstant(node->step)) {
+			throw TypeCheckError("Шаг целой переменной в цикле FOR должен быть целым");
+		}
+		sMakeInteger(node->step);
+	}
+
 	visit(node->body);
 }
 
@@ -170,7 +245,7 @@ void SemanticChecker::visit(CallAstNodePtr node) {
 
 void SemanticChecker::visit(ApplyAstNodePtr node) {
 	if (!node->GetCallee()->is_returning_value) {
-		throw TypeCheckError{"Подпрограмма " + node->GetCallee()->GetName() + " не является функцией"};
+		throw TypeCheckError{"Подпрограмма " + std::string{node->GetCallee()->GetName()} + " не является функцией"};
 	}
 
 	const auto& parameters = node->GetCallee()->GetParameters();
@@ -184,6 +259,9 @@ void SemanticChecker::visit(ApplyAstNodePtr node) {
 	}
 
 	for (int i = 0; i < arguments.size(); ++i) {
+		if (GetIdentifierType(parameters[i]) == DataType::kInteger) {
+			sCoerceToInteger(arguments[i]);
+		}
 		if (GetIdentifierType(parameters[i]) != arguments[i]->GetType()) {
 			throw TypeCheckError{
 				"Тип " + std::to_string(i + 1) + "-го параметра — " + ToString(GetIdentifierType(parameters[i])) +
@@ -199,10 +277,23 @@ void SemanticChecker::visit(BinaryExpressionAstNodePtr node) {
 	visit(node->GetLeftOperand());
 	visit(node->GetRightOperand());
 
-	const auto lhs_type = node->GetLeftOperand()->GetType();
-	const auto rhs_type = node->GetRightOperand()->GetType();
 	const auto operation = node->GetOperation();
 
+	// целые константы принимают тип другого операнда, а у '\' — INTEGER
+	auto* lhs = node->GetLeftOperand();
+	auto* rhs = node->GetRightOperand();
+	if (lhs->OfType(DataType::kInteger)) {
+		sCoerceToInteger(rhs);
+	} else if (rhs->OfType(DataType::kInteger)) {
+		sCoerceToInteger(lhs);
+	} else if (Operation::kIntDiv == operation && sIsIntegerConstant(lhs) && sIsIntegerConstant(rhs)) {
+		sCoerceToInteger(lhs);
+		sCoerceToInteger(rhs);
+	}
+
+	const auto lhs_type = lhs->GetType();
+	const auto rhs_type = rhs->GetType();
+
 	if (lhs_type != rhs_type) {
 		throw TypeCheckError{operation, "операнды имеют различные типы: " + ToString(lhs_type) + " и " + ToString(rhs_type)};
 	}
@@ -218,7 +309,8 @@ void SemanticChecker::visit(BinaryExpressionAstNodePtr node) {
 	} else if (lhs_type == DataType::kNumeric) {
 		const auto is_not_allowed =    operation == Operation::kConc
 		                            || operation == Operation::kAnd
-		                            || operation == Operation::kOr;
+		                            || operation == Operation::kOr
+		                            || operation == Operation::kIntDiv;
 		if (is_not_allowed) {
 			throw TypeCheckError{operation, "не применяется к операндам типа " + ToString(DataType::kNumeric)};
 		}
@@ -228,6 +320,22 @@ void SemanticChecker::visit(BinaryExpressionAstNodePtr node) {
 		} else {
 			node->SetType(DataType::kNumeric);
 		}
+	} else if (lhs_type == DataType::kInteger) {
+		const auto is_not_allowed =    operation == Operation::kConc
+		                            || operation == Operation::kAnd
+		                            || operation == Operation::kOr;
+		if (is_not_allowed) {
+			throw TypeCheckError{operation, "не применяется к операндам типа " + ToString(DataType::kInteger)};
+		}
+
+		// '/' и '^' вычисляются в double
+		if (operation >= Operation::kEq && operation <= Operation::kLe) {
+			node->SetType(DataType::kBoolean);
+		} else if (Operation::kDiv == operation || Operation::kPow == operation) {
+			node->SetType(DataType::kNumeric);
+		} else {
+			node->SetType(DataType::kInteger);
+		}
 	} else if (lhs_type == DataType::kTextual) {
 		if (Operation::kConc == operation) {
 			node->SetType(DataType::kTextual);
@@ -252,14 +360,18 @@ void SemanticChecker::visit(UnaryExpressionAstNodePtr node) {
 		node->SetType(DataType::kBoolean);
 	}
 
-	if (node->GetOperation() == Operation::kSub && node->GetOperand()->NotOfType(DataType::kNumeric)) {
+	if (node->GetOperation() != Operation::kSub) {
+		return;
+	}
+
+	if (node->GetOperand()->NotOfType(DataType::kNumeric) && node->GetOperand()->NotOfType(DataType::kInteger)) {
 		throw TypeCheckError{
 			node->GetOperation(),
 			"Тип операнда — " + ToString(node->GetOperand()->GetType()) +
 			", а должен быть " + ToString(DataType::kNumeric)
 		};
 	} else {
-		node->SetType(DataType::kNumeric);
+		node->SetType(node->GetOperand()->GetType());
 	}
 }
 
@@ -268,7 +380,7 @@ void SemanticChecker::visit(ItemAstNodePtr node) {
 		throw TypeCheckError{"Обращаться по индексу можно только к переменным типа ARRAY"};
 	}
 	visit(node->expression);
-	if (node->expression->NotOfType(DataType::kNumeric)) {
+	if (node->expression->NotOfType(DataType::kNumeric) && node->expression->NotOfType(DataType::kInteger)) {
 		throw TypeCheckError{"Выражение для доступа по индексу должно быть числовым"};
 	}
 }
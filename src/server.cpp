@@ -0,0 +1,127 @@
+#include "server.hpp"
+
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <exception>
+#include <iostream>
+#include <sstream>
+
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include "command_line.hpp"
+#include "compiler.hpp"
+#include "server_protocol.hpp"
+
+
+namespace {
+
+using namespace bsq;
+
+/// Сколько сервер ждёт запрос от подключившегося клиента
+/// и готовность клиента принять очередную часть ответа
+constexpr time_t kRequestTimeoutSeconds = 10;
+
+/// Сокет сервера, удаляемый при завершении по сигналу
+char listening_socket_path[sizeof(sockaddr_un::sun_path)];
+
+void sRemoveSocketAndExit(int) {
+	::unlink(listening_socket_path);
+	::_exit(0);
+}
+
+/// Выполняет запрос клиента и отправляет ему ответ
+void sServeRequest(int fd, CompilerPool& compilers) {
+	const auto request = ReadRequest(fd);
+	if (!request.has_value()) {
+		return;
+	}
+
+	std::ostringstream out;
+	std::ostringstream errors;
+	int status = 1;
+	try {
+		// запросы выполняются по одному, поэтому рабочий каталог
+		// процесса можно сменить на каталог клиента
+		std::filesystem::current_path(request->front());
+
+		const std::vector<std::string> arguments{request->begin() + 1, request->end()};
+		if (const auto command_line = ParseCommandLine(arguments, errors); !command_line.has_value()) {
+			// сообщение уже выведено
+		} else if (command_line->serve_socket.has_value()) {
+			errors << "--serve: сервер не может запустить другой сервер" << std::endl;
+		} else {
+			status = RunCommandLine(*command_line, compilers, out, errors);
+		}
+	}
+	catch (const std::exception& e) {
+		errors << e.what() << std::endl;
+	}
+
+	WriteFrame(fd, ServerFrame::kOut, out.str())
+		&& WriteFrame(fd, ServerFrame::kErrors, errors.str())
+		&& WriteFrame(fd, ServerFrame::kExit, std::to_string(status));
+}
+
+}  // namespace
+
+
+namespace bsq {
+
+int Serve(const std::filesystem::path& socket) {
+	const auto address = MakeServerAddress(socket);
+	if (!address.has_value()) {
+		std::cerr << socket.string() << ": слишком длинный путь сокета" << std::endl;
+		return 1;
+	}
+
+	// Файл сокета мог остаться от завершившегося сервера и удаляется,
+	// но работающий сервер второй не подменяет
+	if (ConnectToServer(*address)) {
+		std::cerr << socket.string() << ": сервер компиляции уже работает" << std::endl;
+		return 1;
+	}
+	::unlink(address->sun_path);
+
+	Socket listener{::socket(AF_UNIX, SOCK_STREAM, 0)};
+	if (!listener
+		|| ::bind(listener.Get(), reinterpret_cast<const sockaddr*>(&*address), sizeof(*address)) != 0
+		|| ::listen(listener.Get(), SOMAXCONN) != 0)
+	{
+		std::cerr << socket.string() << ": " << std::strerror(errno) << std::endl;
+		return 1;
+	}
+
+	std::memcpy(listening_socket_path, address->sun_path, sizeof(listening_socket_path));
+	std::signal(SIGINT, sRemoveSocketAndExit);
+	std::signal(SIGTERM, sRemoveSocketAndExit);
+
+	// первый запрос не ждёт чтения библиотеки
+	CompilerPool compilers;
+	compilers.Release(compilers.Acquire());
+
+	std::cout << "Сервер компиляции слушает " << socket.string() << std::endl;
+	for (;;) {
+		Socket connection{::accept(listener.Get(), nullptr, nullptr)};
+		if (!connection) {
+			if (errno == EINTR || errno == ECONNABORTED) {
+				continue;
+			}
+			std::cerr << socket.string() << ": " << std::strerror(errno) << std::endl;
+			::unlink(listening_socket_path);
+			return 1;
+		}
+
+		// клиент, не приславший запрос или не читающий ответ,
+		// не задерживает остальных
+		const timeval timeout{kRequestTimeoutSeconds, 0};
+		::setsockopt(connection.Get(), SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+		::setsockopt(connection.Get(), SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+		sServeRequest(connection.Get(), compilers);
+	}
+}
+
+}  // namespace bsq
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+
+namespace bsq {
+
+/// @brief Сервер компиляции на Unix-сокете @p socket
+///
+/// Запрос — рабочий каталог клиента и его аргументы командной строки.
+/// Сервер выполняет их так же, как bsq, запущенный в этом каталоге,
+/// и возвращает клиенту вывод и код завершения. Поэтому исходные файлы
+/// передаются только путями: текст программы в запросе не принимается,
+/// компилятор читает файлы сам и пишет .ll рядом с ними. Compiler
+/// с готовой машиной целевой платформы переходят от запроса к запросу.
+/// Запросы обрабатываются по одному, файлы одного запроса с --jobs —
+/// параллельно. Сервер работает до SIGINT или SIGTERM.
+///
+/// Возвращает код завершения процесса.
+int Serve(const std::filesystem::path& socket);
+
+/// Передаёт аргументы @p arguments серверу на @p socket и выводит его ответ;
+/// возвращает код завершения, присланный сервером
+int CompileOnServer(const std::filesystem::path& socket, const std::vector<std::string>& arguments);
+
+}  // namespace bsq
@@ -0,0 +1,51 @@
+#include "server.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+#include "server_protocol.hpp"
+
+
+namespace bsq {
+
+int CompileOnServer(const std::filesystem::path& socket, const std::vector<std::string>& arguments) {
+	const auto address = MakeServerAddress(socket);
+	if (!address.has_value()) {
+		std::cerr << socket.string() << ": слишком длинный путь сокета" << std::endl;
+		return 1;
+	}
+
+	const auto connection = ConnectToServer(*address);
+	if (!connection) {
+		std::cerr << socket.string() << ": сервер компиляции недоступен" << std::endl;
+		return 1;
+	}
+
+	std::vector<std::string> request{std::filesystem::current_path().string()};
+	request.insert(request.end(), arguments.begin(), arguments.end());
+	if (!WriteRequest(connection.Get(), request)) {
+		std::cerr << socket.string() << ": " << std::strerror(errno) << std::endl;
+		return 1;
+	}
+
+	ServerFrame frame{};
+	std::string text;
+	while (ReadFrame(connection.Get(), frame, text)) {
+		switch (frame) {
+			case ServerFrame::kOut:
+				std::cout << text << std::flush;
+				break;
+			case ServerFrame::kErrors:
+				std::cerr << text << std::flush;
+				break;
+			case ServerFrame::kExit:
+				return std::stoi(text);
+		}
+	}
+
+	std::cerr << socket.string() << ": сервер прервал соединение" << std::endl;
+	return 1;
+}
+
+}  // namespace bsq
@@ -0,0 +1,134 @@
+#include "server_protocol.hpp"
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+
+namespace {
+
+/// Больше этого не может занимать ни одна строка запроса или ответа
+constexpr std::uint32_t kMaxMessageSize = 256 * 1024 * 1024;
+
+/// Больше этого не может быть строк в запросе
+constexpr std::uint32_t kMaxRequestSize = 64 * 1024;
+
+bool sWrite(int fd, const void* data, size_t size) {
+	const auto* bytes = static_cast<const char*>(data);
+	while (size > 0) {
+		// MSG_NOSIGNAL: отключившийся клиент не должен завершать сервер SIGPIPE
+		const auto count = ::send(fd, bytes, size, MSG_NOSIGNAL);
+		if (count < 0 && errno == EINTR) {
+			continue;
+		}
+		if (count < 0) {
+			return false;
+		}
+		bytes += count;
+		size -= static_cast<size_t>(count);
+	}
+	return true;
+}
+
+bool sRead(int fd, void* data, size_t size) {
+	auto* bytes = static_cast<char*>(data);
+	while (size > 0) {
+		const auto count = ::recv(fd, bytes, size, 0);
+		if (count < 0 && errno == EINTR) {
+			continue;
+		}
+		if (count <= 0) {
+			return false;
+		}
+		bytes += count;
+		size -= static_cast<size_t>(count);
+	}
+	return true;
+}
+
+bool sWriteString(int fd, std::string_view text) {
+	const auto size = static_cast<std::uint32_t>(text.size());
+	return sWrite(fd, &size, sizeof(size)) && sWrite(fd, text.data(), text.size());
+}
+
+bool sReadString(int fd, std::string& text) {
+	std::uint32_t size = 0;
+	if (!sRead(fd, &size, sizeof(size)) || size > kMaxMessageSize) {
+		return false;
+	}
+
+	text.resize(size);
+	return sRead(fd, text.data(), size);
+}
+
+}  // namespace
+
+
+namespace bsq {
+
+Socket::~Socket() {
+	if (fd_ >= 0) {
+		::close(fd_);
+	}
+}
+
+std::optional<sockaddr_un> MakeServerAddress(const std::filesystem::path& socket) {
+	sockaddr_un address{};
+	address.sun_family = AF_UNIX;
+
+	const auto path = socket.string();
+	if (path.size() >= sizeof(address.sun_path)) {
+		return std::nullopt;
+	}
+	std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+	return address;
+}
+
+Socket ConnectToServer(const sockaddr_un& address) {
+	Socket connection{::socket(AF_UNIX, SOCK_STREAM, 0)};
+	if (connection && ::connect(connection.Get(), reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0) {
+		return Socket{-1};
+	}
+	return connection;
+}
+
+bool WriteRequest(int fd, const std::vector<std::string>& request) {
+	const auto count = static_cast<std::uint32_t>(request.size());
+	if (!sWrite(fd, &count, sizeof(count))) {
+		return false;
+	}
+	for (const auto& text : request) {
+		if (!sWriteString(fd, text)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+std::optional<std::vector<std::string>> ReadRequest(int fd) {
+	std::uint32_t count = 0;
+	if (!sRead(fd, &count, sizeof(count)) || count == 0 || count > kMaxRequestSize) {
+		return std::nullopt;
+	}
+
+	std::vector<std::string> request(count);
+	for (auto& text : request) {
+		if (!sReadString(fd, text)) {
+			return std::nullopt;
+		}
+	}
+	return request;
+}
+
+bool WriteFrame(int fd, ServerFrame frame, std::string_view text) {
+	return sWrite(fd, &frame, sizeof(frame)) && sWriteString(fd, text);
+}
+
+bool ReadFrame(int fd, ServerFrame& frame, std::string& text) {
+	return sRead(fd, &frame, sizeof(frame)) && sReadString(fd, text);
+}
+
+}  // namespace bsq
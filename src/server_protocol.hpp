@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <sys/un.h>
+
+
+namespace bsq {
+
+/// @brief Протокол сервера компиляции
+///
+/// Запрос — число строк (4 байта) и строки: рабочий каталог клиента
+/// и аргументы командной строки. Ответ — кадры: вид (1 байт) и строка.
+/// Строка передаётся длиной (4 байта) и содержимым. Порядок байт —
+/// родной: клиент и сервер работают на одной машине.
+enum class ServerFrame : char {
+	kOut = 'o',     ///< вывод
+	kErrors = 'e',  ///< сообщения об ошибках
+	kExit = 'x',    ///< код завершения, последний кадр
+};
+
+/// Владеет дескриптором сокета
+class Socket {
+public:
+	explicit Socket(int fd)
+		: fd_{fd}
+	{
+	}
+
+	Socket(Socket&& other) noexcept
+		: fd_{std::exchange(other.fd_, -1)}
+	{
+	}
+
+	Socket(const Socket&) = delete;
+	Socket& operator=(const Socket&) = delete;
+
+	~Socket();
+
+	[[nodiscard]] int Get() const { return fd_; }
+	explicit operator bool() const { return fd_ >= 0; }
+
+private:
+	int fd_;
+};
+
+/// Адрес сокета сервера; std::nullopt, если путь не помещается в адрес
+std::optional<sockaddr_un> MakeServerAddress(const std::filesystem::path& socket);
+
+/// Подключается к серверу; при неудаче сокет пуст
+Socket ConnectToServer(const sockaddr_un& address);
+
+bool WriteRequest(int fd, const std::vector<std::string>& request);
+std::optional<std::vector<std::string>> ReadRequest(int fd);
+
+bool WriteFrame(int fd, ServerFrame frame, std::string_view text);
+bool ReadFrame(int fd, ServerFrame& frame, std::string& text);
+
+}  // namespace bsq
@@ -0,0 +1,109 @@
+#include "subroutine_cache.hpp"
+
+#include <fstream>
+#include <iterator>
+#include <system_error>
+#include <utility>
+
+#include <llvm/ADT/SmallString.h>
+#include <llvm/ADT/StringRef.h>
+#include <llvm/Bitcode/BitcodeReader.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/MD5.h>
+#include <llvm/Support/raw_ostream.h>
+
+
+namespace {
+
+/// Всё, что IR вызова берёт у вызываемой подпрограммы: имя, типы
+/// параметров и результата и то, встроенная ли она
+std::string sSignature(bsq::SubroutineAstNodeCPtr subroutine) {
+	std::string signature{subroutine->GetName()};
+	signature += '(';
+	for (const auto& parameter : subroutine->GetParameters()) {
+		signature += static_cast<char>(bsq::GetIdentifierType(parameter));
+	}
+	signature += ')';
+	if (subroutine->is_returning_value) {
+		signature += '=';
+	}
+	if (subroutine->is_builtin) {
+		signature += '!';
+	}
+	signature += '\n';
+	return signature;
+}
+
+}  // namespace
+
+
+namespace bsq {
+
+SubroutineCache::SubroutineCache(std::filesystem::path directory, std::string stamp)
+	: directory_{std::move(directory)}
+	, stamp_{std::move(stamp)}
+{
+}
+
+std::string SubroutineCache::GetKey(SubroutineAstNodeCPtr subroutine) const {
+	llvm::MD5 hash;
+	hash.update(stamp_);
+	hash.update('\n');
+	hash.update(subroutine->token_digest);
+	for (const auto& apply : subroutine->calls) {
+		hash.update(sSignature(apply->GetCallee()));
+	}
+
+	llvm::MD5::MD5Result result;
+	hash.final(result);
+	return std::string{result.digest()};
+}
+
+std::optional<std::string> SubroutineCache::Load(const std::string& key) {
+	std::ifstream in{GetPath_(key), std::ios::binary};
+	std::string bitcode{std::istreambuf_iterator<char>{in}, std::istreambuf_iterator<char>{}};
+
+	// нет записи — пустая строка, она тоже не bitcode
+	const auto* begin = reinterpret_cast<const unsigned char*>(bitcode.data());
+	if (!llvm::isBitcode(begin, begin + bitcode.size())) {
+		++statistics_.misses;
+		return std::nullopt;
+	}
+
+	++statistics_.hits;
+	return bitcode;
+}
+
+void SubroutineCache::Store(const std::string& key, std::string_view bitcode) {
+	const auto path = GetPath_(key);
+
+	std::error_code ec;
+	std::filesystem::create_directories(path.parent_path(), ec);
+	if (ec) {
+		return;
+	}
+
+	// Запись во временный файл и переименование: другой процесс
+	// не прочитает запись, записанную наполовину
+	int fd = -1;
+	llvm::SmallString<128> temporary;
+	if (llvm::sys::fs::createUniqueFile(path.string() + ".%%%%%%.tmp", fd, temporary)) {
+		return;
+	}
+
+	llvm::raw_fd_ostream out{fd, true};
+	out << llvm::StringRef{bitcode.data(), bitcode.size()};
+	out.close();
+
+	if (out.has_error() || llvm::sys::fs::rename(temporary, path.string())) {
+		out.clear_error();
+		llvm::sys::fs::remove(temporary);
+	}
+}
+
+std::filesystem::path SubroutineCache::GetPath_(const std::string& key) const {
+	// первые два знака ключа — подкаталог, чтобы каталоги не разрастались
+	return directory_ / key.substr(0, 2) / (key.substr(2) + ".bc");
+}
+
+}  // namespace bsq
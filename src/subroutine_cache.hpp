@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "ast.hpp"
+
+
+namespace bsq {
+
+/// @brief Дисковый кэш IR подпрограмм
+///
+/// Хранит bitcode модуля каждой подпрограммы. Ключ — MD5 лексем
+/// подпрограммы, сигнатур вызываемых ею подпрограмм и метки компилятора:
+/// пока ничто из этого не изменилось, IR подпрограммы не генерируется
+/// заново. Записи не удаляются; кэш можно очистить, удалив каталог.
+class SubroutineCache {
+public:
+	struct Statistics {
+		size_t hits = 0;
+		size_t misses = 0;
+	};
+
+	/// @p stamp — всё, кроме текста программы, от чего зависит IR
+	/// подпрограмм: версия компилятора, параметры генерации
+	SubroutineCache(std::filesystem::path directory, std::string stamp);
+
+	[[nodiscard]] std::string GetKey(SubroutineAstNodeCPtr subroutine) const;
+
+	/// bitcode подпрограммы с ключом @p key, если он есть в кэше
+	std::optional<std::string> Load(const std::string& key);
+
+	/// Сохраняет bitcode; ошибки записи компиляции не мешают
+	void Store(const std::string& key, std::string_view bitcode);
+
+	[[nodiscard]] const Statistics& GetStatistics() const { return statistics_; }
+
+private:
+	[[nodiscard]] std::filesystem::path GetPath_(const std::string& key) const;
+
+private:
+	std::filesystem::path directory_;
+	std::string stamp_;
+	Statistics statistics_;
+};
+
+}  // namespace bsq
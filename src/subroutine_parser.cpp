@@ -0,0 +1,637 @@
+#include "subroutine_parser.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+
+#include <llvm/ADT/ArrayRef.h>
+#include <llvm/Support/MD5.h>
+
+
+namespace {
+
+bool sAreVariablesNamesEqual(std::string_view first, std::string_view second) {
+	return bsq::NormalizeIdentifier(first) == bsq::NormalizeIdentifier(second);
+}
+
+constexpr bsq::TokenSet kExpressionStart = {
+	bsq::Token::kTrue, bsq::Token::kFalse, bsq::Token::kNumber, bsq::Token::kText,
+	bsq::Token::kIdentifier, bsq::Token::kSub, bsq::Token::kNot, bsq::Token::kLeftPar,
+};
+constexpr bsq::TokenSet kCallArgumentsStart = {
+	bsq::Token::kNumber, bsq::Token::kText, bsq::Token::kIdentifier,
+	bsq::Token::kSub, bsq::Token::kNot, bsq::Token::kLeftPar,
+};
+constexpr bsq::TokenSet kUnaryOperators = {bsq::Token::kSub, bsq::Token::kNot};
+
+double sToNumber(std::string_view value) {
+	return std::stod(std::string{value});
+}
+
+/// Литерал без дробной части, который помещается в int64
+bool sToInteger(std::string_view value, std::int64_t& integer) {
+	const auto* end = value.data() + value.size();
+	const auto [last, error] = std::from_chars(value.data(), end, integer);
+	return error == std::errc{} && last == end;
+}
+
+// Приоритеты операций: чем больше, тем сильнее связывание.
+// Унарные '-' и NOT связывают сильнее всех бинарных операций.
+constexpr int kParenthesisPrecedence = 0;
+constexpr int kComparisonPrecedence = 1;
+constexpr int kAdditionPrecedence = 2;
+constexpr int kMultiplicationPrecedence = 3;
+constexpr int kPowerPrecedence = 4;
+constexpr int kPrimaryPrecedence = 5;
+
+struct BinaryOperator {
+	bsq::Operation operation = bsq::Operation::kNone;
+	int precedence = 0;  ///< 0 — лексема не является бинарной операцией
+	bool is_associative = true;  ///< допустимы ли цепочки вида a op b op c
+};
+
+/// Таблица бинарных операций
+constexpr BinaryOperator sBinaryOperator(bsq::Token token) {
+	switch (token) {
+	case bsq::Token::kEq: return {bsq::Operation::kEq, kComparisonPrecedence, false};
+	case bsq::Token::kNe: return {bsq::Operation::kNe, kComparisonPrecedence, false};
+	case bsq::Token::kGt: return {bsq::Operation::kGt, kComparisonPrecedence, false};
+	case bsq::Token::kGe: return {bsq::Operation::kGe, kComparisonPrecedence, false};
+	case bsq::Token::kLt: return {bsq::Operation::kLt, kComparisonPrecedence, false};
+	case bsq::Token::kLe: return {bsq::Operation::kLe, kComparisonPrecedence, false};
+	case bsq::Token::kAdd: return {bsq::Operation::kAdd, kAdditionPrecedence};
+	case bsq::Token::kSub: return {bsq::Operation::kSub, kAdditionPrecedence};
+	case bsq::Token::kAmp: return {bsq::Operation::kConc, kAdditionPrecedence};
+	case bsq::Token::kOr: return {bsq::Operation::kOr, kAdditionPrecedence};
+	case bsq::Token::kMul: return {bsq::Operation::kMul, kMultiplicationPrecedence};
+	case bsq::Token::kDiv: return {bsq::Operation::kDiv, kMultiplicationPrecedence};
+	case bsq::Token::kIntDiv: return {bsq::Operation::kIntDiv, kMultiplicationPrecedence};
+	case bsq::Token::kMod: return {bsq::Operation::kMod, kMultiplicationPrecedence};
+	case bsq::Token::kAnd: return {bsq::Operation::kAnd, kMultiplicationPrecedence};
+	case bsq::Token::kPow: return {bsq::Operation::kPow, kPowerPrecedence, false};
+	default: return {};
+	}
+}
+
+}  // namespace
+
+
+namespace bsq {
+
+SubroutineParser::SubroutineParser(const TokenBuffer& tokens, Arena& arena)
+	: tokens_{tokens}
+	, arena_{arena}
+{
+}
+
+SubroutineParser::Result SubroutineParser::Parse(size_t position) {
+	position_ = position;
+	result_ = Result{};
+	current_subroutine_ = nullptr;
+	local_variables_.clear();
+
+	try {
+		ParseSubroutine_();
+		ParseNewLines_();
+	}
+	catch (SyntaxParseError& e) {
+		result_.error = e.what();
+	}
+
+	if (current_subroutine_ != nullptr && !result_.error.has_value()) {
+		current_subroutine_->token_digest = Digest_(position, position_);
+	}
+
+	result_.subroutine = current_subroutine_;
+	result_.end = position_;
+	return std::move(result_);
+}
+
+/// Subroutine = 'SUB' IDENT ['(' [IdentList] ')'] Statements 'END' 'SUB'.
+void SubroutineParser::ParseSubroutine_() {
+	VerifyAndEatNextToken_(Token::kSubroutine);
+	auto sub_name = Peek_().value;
+	VerifyAndEatNextToken_(Token::kIdentifier);
+	result_.name = sub_name;
+
+	std::vector<std::string_view> parameters;
+	if (Peek_().OfType(Token::kLeftPar)) {
+		VerifyAndEatNextToken_(Token::kLeftPar);
+		if (Peek_().OfType(Token::kIdentifier)) {
+			auto identifier = Peek_().value;
+			VerifyAndEatNextToken_(Token::kIdentifier);
+			parameters.push_back(Intern_(identifier));
+			while (Peek_().OfType(Token::kComma)) {
+				VerifyAndEatNextToken_(Token::kComma);
+				identifier = Peek_().value;
+				VerifyAndEatNextToken_(Token::kIdentifier);
+				parameters.push_back(Intern_(identifier));
+			}
+		}
+		VerifyAndEatNextToken_(Token::kRightPar);
+	}
+
+	current_subroutine_ = MakeNode_<SubroutineAstNode>(Intern_(sub_name), parameters);
+
+	for (auto& ps : current_subroutine_->GetParameters()) {
+		auto* parameter = MakeNode_<VariableAstNode>(ps);
+		current_subroutine_->local_variables.push_back(parameter);
+		local_variables_.emplace(NormalizeIdentifier(ps), parameter);
+	}
+
+	current_subroutine_->body = ParseStatements_();
+
+	VerifyAndEatNextToken_(Token::kEnd);
+	VerifyAndEatNextToken_(Token::kSubroutine);
+}
+
+/// Statements = NewLines { (Let | Dim | Redim | Input | Print | If | While | For | Call) NewLines }
+StatementAstNodePtr SubroutineParser::ParseStatements_() {
+	ParseNewLines_();
+
+	auto sequence = MakeNode_<SequenceAstNode>();
+	while (true) {
+		StatementAstNodePtr statement;
+		bool is_break = false;
+		switch (Peek_().token) {
+		case Token::kLet:
+			statement = ParseLet_();
+			break;
+		case Token::kDim:
+		case Token::kRedim:
+			statement = ParseDim_();
+			break;
+		case Token::kInput:
+			statement = ParseInput_();
+			break;
+		case Token::kPrint:
+			statement = ParsePrint_();
+			break;
+		case Token::kIf:
+			statement = ParseIf_();
+			break;
+		case Token::kWhile:
+			statement = ParseWhile_();
+			break;
+		case Token::kFor:
+			statement = ParseFor_();
+			break;
+		case Token::kCall:
+			statement = ParseCall_();
+			break;
+		default:
+			is_break = true;
+		}
+		if (is_break) {
+			break;
+		}
+		sequence->items.push_back(statement);
+		ParseNewLines_();
+	}
+
+	return sequence;
+}
+
+/// Let = 'LET' IDENT '=' Expression
+StatementAstNodePtr SubroutineParser::ParseLet_() {
+	VerifyAndEatNextToken_(Token::kLet);
+	auto variable_name = Peek_().value;
+	VerifyAndEatNextToken_(Token::kIdentifier);
+	if (auto array = GetArray_(variable_name)) {
+		VerifyAndEatNextToken_(Token::kLeftPar);
+		auto index = ParseExpression_();
+		VerifyAndEatNextToken_(Token::kRightPar);
+		VerifyAndEatNextToken_(Token::kEq);
+		auto expression = ParseExpression_();
+		auto let = MakeNode_<LetAstNode>(array, expression);
+		let->array_index = index;
+		return let;
+	}
+	VerifyAndEatNextToken_(Token::kEq);
+	auto expression = ParseExpression_();
+
+	auto variable = CreateOrGetLocalVariable_(variable_name, false);
+
+	if (variable_name == current_subroutine_->GetName()) {
+		current_subroutine_->is_returning_value = true;
+	}
+
+	return MakeNode_<LetAstNode>(variable, expression);
+}
+
+/// Dim = 'DIM' IDENT '(' Expression ')'
+/// Redim = 'REDIM' ['PRESERVE'] IDENT '(' Expression ')'
+StatementAstNodePtr SubroutineParser::ParseDim_() {
+	const bool is_redim = Peek_().OfType(Token::kRedim);
+	VerifyAndEatNextToken_(is_redim ? Token::kRedim : Token::kDim);
+	const bool is_preserving = is_redim && Peek_().OfType(Token::kPreserve);
+	if (is_preserving) {
+		VerifyAndEatNextToken_(Token::kPreserve);
+	}
+
+	auto variable_name = Peek_().value;
+	VerifyAndEatNextToken_(Token::kIdentifier);
+	VerifyAndEatNextToken_(Token::kLeftPar);
+	auto size = ParseExpression_();
+	VerifyAndEatNextToken_(Token::kRightPar);
+
+	// размер известен при компиляции, только если массив объявлен
+	// единственным DIM с числом; недопустимое число отвергает SemanticChecker
+	auto variable = CreateOrGetLocalVariable_(variable_name, false);
+	const bool is_declared = variable->OfType(DataType::kArray);
+	auto* number = AstNodeCast<NumberAstNode>(size);
+	const bool is_static = !is_declared && !is_redim && number != nullptr && number->IsIntegral()
+		&& number->GetIntegerValue() >= 0 && static_cast<size_t>(number->GetIntegerValue()) <= VariableAstNode::kMaxArraySize;
+	variable->SetType(DataType::kArray);
+	variable->array_size = is_static ? static_cast<size_t>(number->GetIntegerValue()) : 0;
+
+	/*if (variable_name == current_subroutine_->GetName()) {
+		current_subroutine_->is_returning_value = true;
+	}*/
+
+	return MakeNode_<DimAstNode>(variable, size, is_preserving);
+}
+
+/// Input = 'INPUT' IDENT
+StatementAstNodePtr SubroutineParser::ParseInput_() {
+	VerifyAndEatNextToken_(Token::kInput);
+
+	std::string_view prompt = "?";
+	if (Peek_().OfType(Token::kText)) {
+		prompt = Peek_().value;
+		VerifyAndEatNextToken_(Token::kText);
+		VerifyAndEatNextToken_(Token::kComma);
+	}
+
+	auto variable_name = Peek_().value;
+	VerifyAndEatNextToken_(Token::kIdentifier);
+
+	if (auto array = GetArray_(variable_name)) {
+		VerifyAndEatNextToken_(Token::kLeftPar);
+		auto expression = ParseExpression_();
+		VerifyAndEatNextToken_(Token::kRightPar);
+		auto item = MakeNode_<ItemAstNode>(array, expression);
+		return MakeNode_<InputAstNode>(MakeNode_<TextAstNode>(Intern_(prompt)), nullptr, item);
+	}
+
+	auto variable = CreateOrGetLocalVariable_(variable_name, false);
+	return MakeNode_<InputAstNode>(MakeNode_<TextAstNode>(Intern_(prompt)), variable);
+}
+
+/// Print = 'PRINT' Expression
+StatementAstNodePtr SubroutineParser::ParsePrint_() {
+	VerifyAndEatNextToken_(Token::kPrint);
+	auto expression = ParseExpression_();
+	return MakeNode_<PrintAstNode>(expression);
+}
+
+/// If = 'IF' Expression 'THEN' Statements
+///   {'ELSEIF' Expression 'THEN' Statements }
+///   ['ELSE' Statements] 'END' 'IF'
+StatementAstNodePtr SubroutineParser::ParseIf_() {
+	VerifyAndEatNextToken_(Token::kIf);
+	auto condition = ParseExpression_();
+	VerifyAndEatNextToken_(Token::kThen);
+	auto then = ParseStatements_();
+	auto if_node = MakeNode_<IfAstNode>(condition, then);
+
+	auto it = if_node;
+	while (Peek_().OfType(Token::kElseIf)) {
+		VerifyAndEatNextToken_(Token::kElseIf);
+		auto chained_condition = ParseExpression_();
+		VerifyAndEatNextToken_(Token::kThen);
+		auto chained_then = ParseStatements_();
+		auto chained_if_node = MakeNode_<IfAstNode>(chained_condition, chained_then);
+		it->otherwise = chained_if_node;
+		it = chained_if_node;
+	}
+
+	if (Peek_().OfType(Token::kElse)) {
+		VerifyAndEatNextToken_(Token::kElse);
+		it->otherwise = ParseStatements_();
+	}
+
+	VerifyAndEatNextToken_(Token::kEnd);
+	VerifyAndEatNextToken_(Token::kIf);
+
+	return if_node;
+}
+
+/// While = 'WHILE' Expression Statements 'END' 'WHILE'
+StatementAstNodePtr SubroutineParser::ParseWhile_() {
+	VerifyAndEatNextToken_(Token::kWhile);
+	auto condition = ParseExpression_();
+	auto body = ParseStatements_();
+	VerifyAndEatNextToken_(Token::kEnd);
+	VerifyAndEatNextToken_(Token::kWhile);
+	return MakeNode_<WhileAstNode>(condition, body);
+}
+
+/// For = 'FOR' IDENT '=' Expression 'TO' Expression ['STEP' NUMBER]
+///    Statements 'END' 'FOR'
+StatementAstNodePtr SubroutineParser::ParseFor_() {
+	VerifyAndEatNextToken_(Token::kFor);
+	auto parameter = Peek_().value;
+	VerifyAndEatNextToken_(Token::kIdentifier);
+	VerifyAndEatNextToken_(Token::kEq);
+	auto begin_node = ParseExpression_();
+	VerifyAndEatNextToken_(Token::kTo);
+	auto end_node = ParseExpression_();
+	double step = 1;
+	if (Peek_().OfType(Token::kStep)) {
+		VerifyAndEatNextToken_(Token::kStep);
+		bool is_negative = false;
+		if (Peek_().OfType(Token::kSub)) {
+			VerifyAndEatNextToken_(Token::kSub);
+			is_negative = true;
+		}
+		auto step_value = Peek_().value;
+		VerifyAndEatNextToken_(Token::kNumber);
+		step = sToNumber(step_value);
+		if (is_negative) {
+			step = -step;
+		}
+	}
+	auto step_node = MakeNode_<NumberAstNode>(step);
+	auto variable_node = CreateOrGetLocalVariable_(parameter, false);
+	auto body_node = ParseStatements_();
+	VerifyAndEatNextToken_(Token::kEnd);
+	VerifyAndEatNextToken_(Token::kFor);
+
+	return MakeNode_<ForAstNode>(variable_node, begin_node, end_node, step_node, body_node);
+}
+
+/// Call = 'CALL' IDENT [ExpressionList]
+StatementAstNodePtr SubroutineParser::ParseCall_() {
+	VerifyAndEatNextToken_(Token::kCall);
+	auto name = Peek_().value;
+	VerifyAndEatNextToken_(Token::kIdentifier);
+	std::vector<ExpressionAstNodePtr> arguments;
+
+	if (Peek_().OfTypeIn(kCallArgumentsStart)) {
+		auto expression = ParseExpression_();
+		arguments.push_back(expression);
+		while (Peek_().OfType(Token::kComma)) {
+			VerifyAndEatNextToken_(Token::kComma);
+			expression = ParseExpression_();
+			arguments.push_back(expression);
+		}
+	}
+
+	auto caller = MakeNode_<CallAstNode>(MakeNode_<ApplyAstNode>(nullptr, arguments));
+	result_.calls.push_back({name, caller->subroutine_call});
+
+	return caller;
+}
+
+/// Expression = Operand { BinaryOperator Operand }
+/// Operand = { '-' | 'NOT' } (Primary | '(' Expression ')')
+///
+/// Разбор по приоритетам операций (см. sBinaryOperator). Операнды
+/// и ожидающие операции, включая открытые скобки, хранятся в явных стеках,
+/// поэтому ни длинные цепочки операций, ни глубокие скобки не углубляют
+/// рекурсию. Сравнения и '^' неассоциативны: в a < b < c и a ^ b ^ c
+/// разбор останавливается на второй операции, как и в исходной грамматике
+///   Expression = Addition [Comparison Addition]
+///   Power = Factor ['^' Factor]
+ExpressionAstNodePtr SubroutineParser::ParseExpression_() {
+	struct Operand {
+		ExpressionAstNodePtr node;
+		int precedence;  ///< Приоритет внешней операции узла
+	};
+
+	struct PendingOperation {
+		Operation operation;
+		int precedence;
+		bool is_unary;
+	};
+
+	std::vector<Operand> operands;
+	std::vector<PendingOperation> operations;
+	size_t open_parentheses = 0;
+
+	auto reduce = [&] {
+		const auto pending = operations.back();
+		operations.pop_back();
+
+		auto rhs = operands.back().node;
+		operands.pop_back();
+
+		if (pending.is_unary) {
+			operands.push_back({MakeNode_<UnaryExpressionAstNode>(pending.operation, rhs), kPrimaryPrecedence});
+			return;
+		}
+
+		auto lhs = operands.back().node;
+		operands.pop_back();
+		operands.push_back({MakeNode_<BinaryExpressionAstNode>(pending.operation, lhs, rhs), pending.precedence});
+	};
+
+	while (true) {
+		while (true) {
+			if (Peek_().OfTypeIn(kUnaryOperators)) {
+				const auto operation = Peek_().OfType(Token::kSub) ? Operation::kSub : Operation::kNot;
+				operations.push_back({operation, kPrimaryPrecedence, true});
+				VerifyAndEatNextToken_(Peek_().token);
+			} else if (Peek_().OfType(Token::kLeftPar)) {
+				operations.push_back({Operation::kNone, kParenthesisPrecedence, false});
+				VerifyAndEatNextToken_(Token::kLeftPar);
+				++open_parentheses;
+			} else {
+				break;
+			}
+		}
+
+		operands.push_back({ParsePrimary_(), kPrimaryPrecedence});
+
+		while (true) {
+			while (!operations.empty() && operations.back().is_unary) {
+				reduce();
+			}
+
+			if (open_parentheses == 0 || !Peek_().OfType(Token::kRightPar)) {
+				break;
+			}
+
+			while (operations.back().precedence != kParenthesisPrecedence) {
+				reduce();
+			}
+			operations.pop_back();
+			--open_parentheses;
+			VerifyAndEatNextToken_(Token::kRightPar);
+			operands.back().precedence = kPrimaryPrecedence;
+		}
+
+		const auto binary = sBinaryOperator(Peek_().token);
+		if (binary.precedence == 0) {
+			break;
+		}
+
+		while (!operations.empty() && operations.back().precedence >= binary.precedence) {
+			reduce();
+		}
+
+		const auto lhs_precedence = operands.back().precedence;
+		const bool is_allowed = binary.is_associative
+			? lhs_precedence >= binary.precedence
+			: lhs_precedence > binary.precedence;
+		if (!is_allowed) {
+			break;
+		}
+
+		operations.push_back({binary.operation, binary.precedence, false});
+		VerifyAndEatNextToken_(Peek_().token);
+	}
+
+	if (open_parentheses != 0) {
+		VerifyAndEatNextToken_(Token::kRightPar);  // бросает исключение
+	}
+
+	while (!operations.empty()) {
+		reduce();
+	}
+
+	return operands.back().node;
+}
+
+/// Primary = TRUE | FALSE | NUMBER | TEXT | IDENT
+///         | IDENT '(' [ExpressionList] ')'
+ExpressionAstNodePtr SubroutineParser::ParsePrimary_() {
+	// TRUE & FALSE
+	if (Peek_().OfType(Token::kTrue)) {
+		VerifyAndEatNextToken_(Token::kTrue);
+		return MakeNode_<BooleanAstNode>(true);
+	} else if (Peek_().OfType(Token::kFalse)) {
+		VerifyAndEatNextToken_(Token::kFalse);
+		return MakeNode_<BooleanAstNode>(false);
+	}
+
+	// NUMBER
+	if (Peek_().OfType(Token::kNumber)) {
+		auto value = Peek_().value;
+		VerifyAndEatNextToken_(Token::kNumber);
+		if (std::int64_t integer = 0; sToInteger(value, integer)) {
+			return MakeNode_<NumberAstNode>(sToNumber(value), integer);
+		}
+		return MakeNode_<NumberAstNode>(sToNumber(value));
+	}
+
+	// TEXT
+	if (Peek_().OfType(Token::kText)) {
+		auto value = Peek_().value;
+		VerifyAndEatNextToken_(Token::kText);
+		return MakeNode_<TextAstNode>(Intern_(value));
+	}
+
+	// IDENT ['(' [ExpressionList] ')']
+	if (Peek_().OfType(Token::kIdentifier)) {
+		auto name = Peek_().value;
+		if (auto array = GetArray_(name)) {
+			VerifyAndEatNextToken_(Token::kIdentifier);
+			VerifyAndEatNextToken_(Token::kLeftPar);
+			auto expression = ParseExpression_();
+			VerifyAndEatNextToken_(Token::kRightPar);
+			return MakeNode_<ItemAstNode>(array, expression);
+		}
+
+		VerifyAndEatNextToken_(Token::kIdentifier);
+		if (Peek_().OfType(Token::kLeftPar)) {
+			std::vector<ExpressionAstNodePtr> arguments;
+			VerifyAndEatNextToken_(Token::kLeftPar);
+			if (Peek_().OfTypeIn(kExpressionStart)) {
+				auto expression = ParseExpression_();
+				arguments.push_back(expression);
+				while (Peek_().OfType(Token::kComma)) {
+					VerifyAndEatNextToken_(Token::kComma);
+					expression = ParseExpression_();
+					arguments.push_back(expression);
+				}
+			}
+			VerifyAndEatNextToken_(Token::kRightPar);
+
+			auto applier = MakeNode_<ApplyAstNode>(nullptr, arguments);
+			applier->SetType(GetIdentifierType(name));
+			result_.calls.push_back({name, applier});
+
+			return applier;
+		}
+		return CreateOrGetLocalVariable_(name, true);
+	}
+
+	throw SyntaxParseError{"Ожидалось NUMBER, TEXT, '-', NOT, IDENT или '(', получено: " + std::string{Peek_().value}};
+}
+
+void SubroutineParser::ParseNewLines_() {
+	VerifyAndEatNextToken_(Token::kNewLine);
+	while (Peek_().OfType(Token::kNewLine)) {
+		VerifyAndEatNextToken_(Token::kNewLine);
+	}
+}
+
+void SubroutineParser::VerifyAndEatNextToken_(Token token) {
+	if (!Peek_().OfType(token)) {
+		throw SyntaxParseError{"Ожидалось: " + ToString(token) + ", получено: " + std::string{Peek_().value}};
+	}
+
+	if (position_ + 1 < tokens_.Size()) {
+		++position_;
+	}
+}
+
+Lexeme SubroutineParser::Peek_(size_t ahead) const {
+	return tokens_.GetLexeme(std::min(position_ + ahead, tokens_.Size() - 1));
+}
+
+std::array<std::uint8_t, 16> SubroutineParser::Digest_(size_t first, size_t last) const {
+	llvm::MD5 hash;
+	for (size_t i = first; i < last; ++i) {
+		// вид и длина перед текстом, чтобы разные последовательности
+		// лексем не давали одинаковый поток байт
+		const auto value = tokens_.GetValue(i);
+		const auto size = static_cast<std::uint32_t>(value.size());
+		const std::array<std::uint8_t, 5> header = {
+			static_cast<std::uint8_t>(tokens_.GetToken(i)),
+			static_cast<std::uint8_t>(size), static_cast<std::uint8_t>(size >> 8),
+			static_cast<std::uint8_t>(size >> 16), static_cast<std::uint8_t>(size >> 24),
+		};
+		hash.update(header);
+		hash.update(llvm::StringRef{value.data(), value.size()});
+	}
+
+	llvm::MD5::MD5Result result;
+	hash.final(result);
+	return result;
+}
+
+VariableAstNodePtr SubroutineParser::CreateOrGetLocalVariable_(std::string_view name, bool is_r_value) {
+	auto& locals = current_subroutine_->local_variables;
+
+	if (is_r_value && sAreVariablesNamesEqual(current_subroutine_->GetName(), name)) {
+		throw SyntaxParseError("Имя подпрограммы используется как rvalue");
+	}
+
+	if (auto it = local_variables_.find(NormalizeIdentifier(name)); it != local_variables_.end()) {
+		return it->second;
+	}
+
+	if (is_r_value) {
+		throw SyntaxParseError(std::string{name} + " — переменная ещё не определена");
+	}
+
+	auto variable = MakeNode_<VariableAstNode>(Intern_(name));
+	locals.push_back(variable);
+	local_variables_.emplace(NormalizeIdentifier(variable->GetName()), variable);
+
+	return variable;
+}
+
+VariableAstNodePtr SubroutineParser::GetArray_(std::string_view name) {
+	auto it = local_variables_.find(NormalizeIdentifier(name));
+	if (it != local_variables_.end() && it->second->OfType(DataType::kArray)) {
+		return it->second;
+	}
+
+	return nullptr;
+}
+
+}  // namespace bsq
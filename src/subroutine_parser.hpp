@@ -0,0 +1,120 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <exception>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "arena.hpp"
+#include "ast.hpp"
+#include "lexeme.hpp"
+#include "token_buffer.hpp"
+
+
+namespace bsq {
+
+class SyntaxParseError : public std::exception {
+public:
+	explicit SyntaxParseError(std::string message)
+		: message_{std::move(message)}
+	{
+	}
+
+	[[nodiscard]] const char* what() const noexcept override {
+		return message_.c_str();
+	}
+
+private:
+	std::string message_;
+};
+
+
+/// @brief Синтаксический анализатор одной подпрограммы
+///
+/// Разбирает подпрограмму, не обращаясь к остальным: вызовы не связываются
+/// с вызываемыми подпрограммами, а запоминаются в порядке появления
+/// в тексте, и связывает их SyntaxParser. Поэтому разные подпрограммы
+/// можно разбирать одновременно, каждую своим анализатором и в своей арене.
+class SubroutineParser {
+public:
+	/// Вызов подпрограммы, который ещё предстоит связать
+	struct Call {
+		std::string_view name;
+		ApplyAstNodePtr apply;
+	};
+
+	struct Result {
+		std::string_view name;  ///< Имя из заголовка; пусто, если заголовок не разобран
+		SubroutineAstNodePtr subroutine = nullptr;
+		std::vector<Call> calls;
+		std::optional<std::string> error;  ///< Первая синтаксическая ошибка
+		size_t end = 0;  ///< Индекс лексемы после подпрограммы и переводов строк
+	};
+
+	/// Узлы создаются в @p arena; @p tokens должен жить дольше анализатора
+	SubroutineParser(const TokenBuffer& tokens, Arena& arena);
+
+	/// Subroutine NewLines, начиная с лексемы с индексом @p position
+	Result Parse(size_t position);
+
+private:
+	void ParseSubroutine_();
+	StatementAstNodePtr ParseStatements_();
+	StatementAstNodePtr ParseInput_();
+	StatementAstNodePtr ParsePrint_();
+	StatementAstNodePtr ParseLet_();
+	StatementAstNodePtr ParseDim_();
+	StatementAstNodePtr ParseIf_();
+	StatementAstNodePtr ParseWhile_();
+	StatementAstNodePtr ParseFor_();
+	StatementAstNodePtr ParseCall_();
+	ExpressionAstNodePtr ParseExpression_();
+	ExpressionAstNodePtr ParsePrimary_();
+
+	void ParseNewLines_();
+
+	void VerifyAndEatNextToken_(Token token);
+
+	/// Лексема через @p ahead позиций от текущей (не дальше Eof)
+	[[nodiscard]] Lexeme Peek_(size_t ahead = 0) const;
+
+	/// MD5 видов и текстов лексем с индексами [first, last)
+	[[nodiscard]] std::array<std::uint8_t, 16> Digest_(size_t first, size_t last) const;
+
+	/// Создаёт локальную переменную или возвращает уже существующую
+	VariableAstNodePtr CreateOrGetLocalVariable_(std::string_view name, bool is_r_value);
+	VariableAstNodePtr GetArray_(std::string_view name);
+
+	/// Создаёт узел в арене анализатора
+	template <typename P, typename... Args>
+	P* MakeNode_(Args&& ... args) {
+		return MakeAstNode<P>(arena_, std::forward<Args>(args)...);
+	}
+
+	/// Копирует строку в арену: срезы исходного текста живут
+	/// только до конца разбора
+	std::string_view Intern_(std::string_view text) {
+		return arena_.Intern(text);
+	}
+
+private:
+	const TokenBuffer& tokens_;
+	Arena& arena_;
+
+	size_t position_ = 0;  ///< Индекс текущей лексемы в tokens_
+	Result result_;
+
+	SubroutineAstNodePtr current_subroutine_ = nullptr;
+
+	/// Локальные переменные и параметры текущей подпрограммы. Ключи —
+	/// имена из арены без суффикса типа, поэтому 'a', 'a$' и 'a?'
+	/// считаются одним именем.
+	std::unordered_map<std::string_view, VariableAstNodePtr> local_variables_;
+};
+
+}  // namespace bsq
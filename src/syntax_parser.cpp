@@ -1,614 +1,219 @@
 #include "syntax_parser.hpp"
 
 #include <algorithm>
-#include <exception>
 #include <iostream>
 #include <memory>
 #include <utility>
 
+#include <llvm/Support/ThreadPool.h>
+
+#include "trace.hpp"
+
 
 namespace {
 
-bool sAreVariablesNamesEqual(std::string_view first, std::string_view second) {
-	std::string_view a = first, b = second;
-	if (a.ends_with('$') || a.ends_with('?')) {
-		a.remove_suffix(1);
-	}
-	if (b.ends_with('$') || b.ends_with('?')) {
-		b.remove_suffix(1);
-	}
-	return a == b;
-}
+/// Тексты короче этого числа байт разбираются в одном потоке:
+/// запуск потоков обходится дороже самого разбора
+constexpr size_t kMinParallelSize = 64 * 1024;
 
-bsq::Operation sToOperation(bsq::Token token) {
-	switch (token) {
-	case bsq::Token::kAdd: return bsq::Operation::kAdd;
-	case bsq::Token::kSub: return bsq::Operation::kSub;
-	case bsq::Token::kAmp: return bsq::Operation::kConc;
-	case bsq::Token::kMul: return bsq::Operation::kMul;
-	case bsq::Token::kDiv: return bsq::Operation::kDiv;
-	case bsq::Token::kMod: return bsq::Operation::kMod;
-	case bsq::Token::kPow: return bsq::Operation::kPow;
-	case bsq::Token::kEq: return bsq:: Operation::kEq;
-	case bsq::Token::kNe: return bsq:: Operation::kNe;
-	case bsq::Token::kGt: return bsq:: Operation::kGt;
-	case bsq::Token::kGe: return bsq:: Operation::kGe;
-	case bsq::Token::kLt: return bsq:: Operation::kLt;
-	case bsq::Token::kLe: return bsq:: Operation::kLe;
-	case bsq::Token::kAnd: return bsq::Operation::kAnd;
-	case bsq::Token::kOr: return bsq:: Operation::kOr;
-	default:
-		throw "unknown token";
-	}
-}
+/// Подпрограммы раздаются потокам пакетами; пакетов больше, чем потоков,
+/// чтобы крупные подпрограммы не задерживали остальные потоки
+constexpr size_t kBatchesPerThread = 4;
 
 }  // namespace
 
 
 namespace bsq {
 
-class SyntaxParseError : public std::exception {
-public:
-	explicit SyntaxParseError(std::string message)
-		: message_{std::move(message)}
-	{
-	}
-
-	[[nodiscard]] const char* what() const noexcept override {
-		return message_.c_str();
-	}
-
-private:
-	std::string message_;
-};
-
-
-SyntaxParser::SyntaxParser(const std::filesystem::path& filename)
+SyntaxParser::SyntaxParser(const std::filesystem::path& filename, std::ostream& errors)
 	: reader_{filename}
+	, errors_{errors}
 {
 	builtin_subroutines_ = {
 		BuiltinSubroutine{"SQR", {"a"}, true},
 
+		// явные преобразования между NUMBER и INTEGER
+		BuiltinSubroutine{"FIX%", {"a"}, true},
+		BuiltinSubroutine{"CDBL", {"a%"}, true},
+
 		BuiltinSubroutine{"MID$", {"a$", "b", "c"}, true},
 		BuiltinSubroutine{"STR$", {"a"}, true},
 	};
 
-	program_ = MakeAstNode<ProgramAstNode>(filename.string());
+	program_ = std::make_unique<ProgramAstNode>(filename.string());
 }
 
-ProgramAstNodePtr SyntaxParser::Parse() {
+ProgramAstNodeOwner SyntaxParser::Parse(llvm::ThreadPool* pool) {
+	TRACE(Parse);
+
+	// смещения лексем в TokenBuffer 32-битные
+	if (reader_.GetSize() > TokenBuffer::kMaxSourceSize) {
+		errors_ << "Исходный текст больше " << TokenBuffer::kMaxSourceSize << " байт" << std::endl;
+		return nullptr;
+	}
+
+	const bool is_parallel = pool != nullptr
+		&& pool->getThreadCount() > 1
+		&& reader_.GetSize() >= kMinParallelSize;
+
+	tokens_ = is_parallel ? reader_.Tokenize(*pool) : reader_.Tokenize();
+
 	try {
-		ParseProgram_();
+		ParseProgram_(is_parallel ? pool : nullptr);
 	}
 	catch (SyntaxParseError& e) {
-		std::cerr << "Синтаксическая ошибка: " << e.what() << std::endl;
+		errors_ << "Синтаксическая ошибка: " << e.what() << std::endl;
 		return nullptr;
 	}
 
 	if (unresolved_links_.empty()) {
-		return program_;
+		return std::move(program_);
 	}
 
+	// порядок сообщений не должен зависеть от порядка обхода хеш-таблицы
+	std::vector<std::string_view> unresolved_names;
 	for (auto& e : unresolved_links_) {
-		std::cerr << "Синтаксическая ошибка: " << e.first << " — неразрешённая ссылка на подпрограмму" << std::endl;
-	}
-
-	return nullptr;
-}
-
-/// Program [NewLines] { Subroutine NewLines }
-void SyntaxParser::ParseProgram_() {
-	reader_ >> next_lexeme_;
-
-	if (next_lexeme_.OfType(Token::kNewLine)) {
-		ParseNewLines_();
+		unresolved_names.push_back(e.second.name);
 	}
+	std::sort(unresolved_names.begin(), unresolved_names.end());
 
-	while (!next_lexeme_.OfType(Token::kEof)) {
-		ParseSubroutine_();
-		ParseNewLines_();
+	for (auto name : unresolved_names) {
+		errors_ << "Синтаксическая ошибка: " << name << " — неразрешённая ссылка на подпрограмму" << std::endl;
 	}
 
-	VerifyAndEatNextToken_(Token::kEof);
+	return nullptr;
 }
 
-/// Subroutine = 'SUB' IDENT ['(' [IdentList] ')'] Statements 'END' 'SUB'.
-void SyntaxParser::ParseSubroutine_() {
-	VerifyAndEatNextToken_(Token::kSubroutine);
-	auto sub_name = next_lexeme_.value;
-	VerifyAndEatNextToken_(Token::kIdentifier);
-
-	auto exists = find_if(program_->subroutines.begin(), program_->subroutines.end(), [&sub_name](auto sp) {
-		return sAreVariablesNamesEqual(sub_name, sp->GetName()); }
-	);
-	if (exists != program_->subroutines.end()) {
-		throw SyntaxParseError(sub_name + " — подпрограмма с таким именем уже определена");
-	}
-
-	std::vector<std::string> parameters;
-	if (next_lexeme_.OfType(Token::kLeftPar)) {
-		VerifyAndEatNextToken_(Token::kLeftPar);
-		if (next_lexeme_.OfType(Token::kIdentifier)) {
-			auto identifier = next_lexeme_.value;
-			VerifyAndEatNextToken_(Token::kIdentifier);
-			parameters.push_back(identifier);
-			while (next_lexeme_.OfType(Token::kComma)) {
-				VerifyAndEatNextToken_(Token::kComma);
-				identifier = next_lexeme_.value;
-				VerifyAndEatNextToken_(Token::kIdentifier);
-				parameters.push_back(identifier);
-			}
-		}
-		VerifyAndEatNextToken_(Token::kRightPar);
-	}
-
-	current_subroutine_ = MakeAstNode<SubroutineAstNode>(sub_name, parameters);
-	program_->subroutines.push_back(current_subroutine_);
-
-	for (auto& ps : current_subroutine_->GetParameters()) {
-		current_subroutine_->local_variables.push_back(MakeAstNode<VariableAstNode>(ps));
+void SyntaxParser::ParseProgram_(llvm::ThreadPool* pool) {
+	size_t position = 0;
+	while (tokens_.GetToken(position) == Token::kNewLine) {
+		++position;
 	}
 
-	current_subroutine_->body = ParseStatements_();
+	const auto starts = FindSubroutines_(position);
+	auto parsed = ParseSubroutines_(starts, pool);
 
-	VerifyAndEatNextToken_(Token::kEnd);
-	VerifyAndEatNextToken_(Token::kSubroutine);
-
-	if (auto link = unresolved_links_.find(sub_name); link != unresolved_links_.end()) {
-		for (auto& apply : link->second) {
-			apply->SetCallee(current_subroutine_);
+	// Подпрограммы добавляются строго по порядку. Заранее разобранная
+	// подпрограмма используется, только если последовательный разбор
+	// начал бы её с той же лексемы, иначе она разбирается заново.
+	SubroutineParser parser{tokens_, program_->arena};
+	size_t next = 0;
+	while (tokens_.GetToken(position) != Token::kEof) {
+		while (next < starts.size() && starts[next] < position) {
+			++next;
 		}
-		unresolved_links_.erase(link);
-	}
-}
 
-/// Statements = NewLines { (Let | Dim | Input | Print | If | While | For | Call) NewLines }
-StatementAstNodePtr SyntaxParser::ParseStatements_() {
-	ParseNewLines_();
-
-	auto sequence = MakeAstNode<SequenceAstNode>();
-	while (true) {
-		StatementAstNodePtr statement;
-		bool is_break = false;
-		switch (next_lexeme_.token) {
-		case Token::kLet:
-			statement = ParseLet_();
-			break;
-		case Token::kDim:
-			statement = ParseDim_();
-			break;
-		case Token::kInput:
-			statement = ParseInput_();
-			break;
-		case Token::kPrint:
-			statement = ParsePrint_();
-			break;
-		case Token::kIf:
-			statement = ParseIf_();
-			break;
-		case Token::kWhile:
-			statement = ParseWhile_();
-			break;
-		case Token::kFor:
-			statement = ParseFor_();
-			break;
-		case Token::kCall:
-			statement = ParseCall_();
-			break;
-		default:
-			is_break = true;
-		}
-		if (is_break) {
-			break;
-		}
-		sequence->items.push_back(statement);
-		ParseNewLines_();
+		auto result = next < starts.size() && starts[next] == position && parsed[next].has_value()
+			? std::move(*parsed[next])
+			: parser.Parse(position);
+		Link_(result);
+		position = result.end;
 	}
-
-	return sequence;
 }
 
-/// Let = 'LET' IDENT '=' Expression
-StatementAstNodePtr SyntaxParser::ParseLet_() {
-	VerifyAndEatNextToken_(Token::kLet);
-	auto variable_name = next_lexeme_.value;
-	VerifyAndEatNextToken_(Token::kIdentifier);
-	if (auto array = GetArray_(variable_name)) {
-		VerifyAndEatNextToken_(Token::kLeftPar);
-		auto index = ParseExpression_();
-		VerifyAndEatNextToken_(Token::kRightPar);
-		VerifyAndEatNextToken_(Token::kEq);
-		auto expression = ParseExpression_();
-		auto let = MakeAstNode<LetAstNode>(array, expression);
-		let->array_index = index;
-		return let;
-	}
-	VerifyAndEatNextToken_(Token::kEq);
-	auto expression = ParseExpression_();
-
-	auto variable = CreateOrGetLocalVariable_(variable_name, false);
-
-	if (variable_name == current_subroutine_->GetName()) {
-		current_subroutine_->is_returning_value = true;
-	}
-
-	return MakeAstNode<LetAstNode>(variable, expression);
-}
-
-/// Dim = 'DIM' IDENT '(' Size ')'
-StatementAstNodePtr SyntaxParser::ParseDim_() {
-	VerifyAndEatNextToken_(Token::kDim);
-	auto variable_name = next_lexeme_.value;
-	VerifyAndEatNextToken_(Token::kIdentifier);
-	VerifyAndEatNextToken_(Token::kLeftPar);
-
-	NumberAstNodePtr size;
-	if (next_lexeme_.OfType(Token::kNumber)) {
-		auto value = next_lexeme_.value;
-		VerifyAndEatNextToken_(Token::kNumber);
-		size = MakeAstNode<NumberAstNode>(std::stod(value));
-	}
-
-	VerifyAndEatNextToken_(Token::kRightPar);
-
-	auto variable = CreateOrGetLocalVariable_(variable_name, false);
-	variable->SetType(DataType::kArray);
-	variable->array_size = static_cast<size_t>(size->GetValue());
-
-	/*if (variable_name == current_subroutine_->GetName()) {
-		current_subroutine_->is_returning_value = true;
-	}*/
-
-	return MakeAstNode<DimAstNode>(variable, size);
-}
-
-/// Input = 'INPUT' IDENT
-StatementAstNodePtr SyntaxParser::ParseInput_() {
-	VerifyAndEatNextToken_(Token::kInput);
-
-	std::string prompt = "?";
-	if (next_lexeme_.OfType(Token::kText)) {
-		prompt = next_lexeme_.value;
-		VerifyAndEatNextToken_(Token::kText);
-		VerifyAndEatNextToken_(Token::kComma);
-	}
-
-	auto variable_name = next_lexeme_.value;
-	VerifyAndEatNextToken_(Token::kIdentifier);
-
-	if (auto array = GetArray_(variable_name)) {
-		VerifyAndEatNextToken_(Token::kLeftPar);
-		auto expression = ParseExpression_();
-		VerifyAndEatNextToken_(Token::kRightPar);
-		auto item = MakeAstNode<ItemAstNode>(array, expression);
-		return MakeAstNode<InputAstNode>(MakeAstNode<TextAstNode>(prompt), nullptr, item);
-	}
-
-	auto variable = CreateOrGetLocalVariable_(variable_name, false);
-	return MakeAstNode<InputAstNode>(MakeAstNode<TextAstNode>(prompt), variable);
-}
-
-/// Print = 'PRINT' Expression
-StatementAstNodePtr SyntaxParser::ParsePrint_() {
-	VerifyAndEatNextToken_(Token::kPrint);
-	auto expression = ParseExpression_();
-	return MakeAstNode<PrintAstNode>(expression);
-}
-
-/// If = 'IF' Expression 'THEN' Statements
-///   {'ELSEIF' Expression 'THEN' Statements }
-///   ['ELSE' Statements] 'END' 'IF'
-StatementAstNodePtr SyntaxParser::ParseIf_() {
-	VerifyAndEatNextToken_(Token::kIf);
-	auto condition = ParseExpression_();
-	VerifyAndEatNextToken_(Token::kThen);
-	auto then = ParseStatements_();
-	auto if_node = MakeAstNode<IfAstNode>(condition, then);
-
-	auto it = if_node;
-	while (next_lexeme_.OfType(Token::kElseIf)) {
-		VerifyAndEatNextToken_(Token::kElseIf);
-		auto chained_condition = ParseExpression_();
-		VerifyAndEatNextToken_(Token::kThen);
-		auto chained_then = ParseStatements_();
-		auto chained_if_node = MakeAstNode<IfAstNode>(chained_condition, chained_then);
-		it->otherwise = chained_if_node;
-		it = chained_if_node;
-	}
-
-	if (next_lexeme_.OfType(Token::kElse)) {
-		VerifyAndEatNextToken_(Token::kElse);
-		it->otherwise = ParseStatements_();
-	}
-
-	VerifyAndEatNextToken_(Token::kEnd);
-	VerifyAndEatNextToken_(Token::kIf);
-
-	return if_node;
-}
-
-/// While = 'WHILE' Expression Statements 'END' 'WHILE'
-StatementAstNodePtr SyntaxParser::ParseWhile_() {
-	VerifyAndEatNextToken_(Token::kWhile);
-	auto condition = ParseExpression_();
-	auto body = ParseStatements_();
-	VerifyAndEatNextToken_(Token::kEnd);
-	VerifyAndEatNextToken_(Token::kWhile);
-	return MakeAstNode<WhileAstNode>(condition, body);
-}
-
-/// For = 'FOR' IDENT '=' Expression 'TO' Expression ['STEP' NUMBER]
-///    Statements 'END' 'FOR'
-StatementAstNodePtr SyntaxParser::ParseFor_() {
-	VerifyAndEatNextToken_(Token::kFor);
-	auto parameter = next_lexeme_.value;
-	VerifyAndEatNextToken_(Token::kIdentifier);
-	VerifyAndEatNextToken_(Token::kEq);
-	auto begin_node = ParseExpression_();
-	VerifyAndEatNextToken_(Token::kTo);
-	auto end_node = ParseExpression_();
-	double step = 1;
-	if (next_lexeme_.OfType(Token::kStep)) {
-		VerifyAndEatNextToken_(Token::kStep);
-		bool is_negative = false;
-		if (next_lexeme_.OfType(Token::kSub)) {
-			VerifyAndEatNextToken_(Token::kSub);
-			is_negative = true;
-		}
-		auto step_value = next_lexeme_.value;
-		VerifyAndEatNextToken_(Token::kNumber);
-		step = std::stod(step_value);
-		if (is_negative) {
-			step = -step;
+std::vector<size_t> SyntaxParser::FindSubroutines_(size_t position) const {
+	// SUB в начале строки. В 'END SUB' перед SUB стоит END, а строка тела,
+	// начинающаяся с SUB, — ошибка, которую найдёт разбор подпрограммы
+	std::vector<size_t> starts{position};
+	for (size_t i = position + 1; i < tokens_.Size(); ++i) {
+		if (tokens_.GetToken(i) == Token::kSubroutine && tokens_.GetToken(i - 1) == Token::kNewLine) {
+			starts.push_back(i);
 		}
 	}
-	auto step_node = MakeAstNode<NumberAstNode>(step);
-	auto variable_node = CreateOrGetLocalVariable_(parameter, false);
-	auto body_node = ParseStatements_();
-	VerifyAndEatNextToken_(Token::kEnd);
-	VerifyAndEatNextToken_(Token::kFor);
-
-	return MakeAstNode<ForAstNode>(variable_node, begin_node, end_node, step_node, body_node);
+	return starts;
 }
 
-/// Call = 'CALL' IDENT [ExpressionList]
-StatementAstNodePtr SyntaxParser::ParseCall_() {
-	VerifyAndEatNextToken_(Token::kCall);
-	auto name = next_lexeme_.value;
-	VerifyAndEatNextToken_(Token::kIdentifier);
-	std::vector<ExpressionAstNodePtr> arguments;
-
-	if (next_lexeme_.OfTypeIn({Token::kNumber, Token::kText, Token::kIdentifier, Token::kSub, Token::kNot, Token::kLeftPar})) {
-		auto expression = ParseExpression_();
-		arguments.push_back(expression);
-		while (next_lexeme_.OfType(Token::kComma)) {
-			VerifyAndEatNextToken_(Token::kComma);
-			expression = ParseExpression_();
-			arguments.push_back(expression);
-		}
-	}
-
-	auto caller = MakeAstNode<CallAstNode>(nullptr, arguments);
-
-	auto callee = SafeGetSubroutine_(name);
-	if (callee == nullptr) {
-		unresolved_links_[name].push_back(caller->subroutine_call);
+std::vector<std::optional<SubroutineParser::Result>> SyntaxParser::ParseSubroutines_(const std::vector<size_t>& starts, llvm::ThreadPool* pool) {
+	std::vector<std::optional<SubroutineParser::Result>> parsed(starts.size());
+	if (pool == nullptr || starts.size() < 2) {
+		return parsed;
 	}
 
-	caller->subroutine_call->SetCallee(callee);
-
-	return caller;
-}
-
-/// Expression = Addition [('=' | '<>' | '>' | '>=' | '<' | '<=') Addition]
-ExpressionAstNodePtr SyntaxParser::ParseExpression_() {
-	auto result = ParseAddition_();
-	if (next_lexeme_.OfTypeIn({Token::kEq, Token::kNe, Token::kGt, Token::kGe, Token::kLt, Token::kLe})) {
-		auto operation = sToOperation(next_lexeme_.token);
-		VerifyAndEatNextToken_(next_lexeme_.token);
-		auto expression = ParseAddition_();
-		result = MakeAstNode<BinaryExpressionAstNode>(operation, result, expression);
-	}
-	return result;
-}
-
-/// Addition = Multiplication {('+' | '-' | '&' | 'OR') Multiplication}
-ExpressionAstNodePtr SyntaxParser::ParseAddition_() {
-	auto result = ParseMultiplication_();
-	while (next_lexeme_.OfTypeIn({Token::kAdd, Token::kSub, Token::kAmp, Token::kOr})) {
-		auto operation = sToOperation(next_lexeme_.token);
-		VerifyAndEatNextToken_(next_lexeme_.token);
-		auto expression = ParseMultiplication_();
-		result = MakeAstNode<BinaryExpressionAstNode>(operation, result, expression);
-	}
-	return result;
-}
-
-/// Multiplication = Power {('*' | '/' | '\' | 'AND') Power}
-ExpressionAstNodePtr SyntaxParser::ParseMultiplication_() {
-	auto result = ParsePower_();
-	while (next_lexeme_.OfTypeIn({Token::kMul, Token::kDiv, Token::kMod, Token::kAnd})) {
-		auto operation = sToOperation(next_lexeme_.token);
-		VerifyAndEatNextToken_(next_lexeme_.token);
-		auto expression = ParsePower_();
-		result = MakeAstNode<BinaryExpressionAstNode>(operation, result, expression);
-	}
-	return result;
-}
-
-/// Power = Factor ['^' Power]
-ExpressionAstNodePtr SyntaxParser::ParsePower_() {
-	auto result = ParseFactor_();
-	if (next_lexeme_.OfType(Token::kPow)) {
-		VerifyAndEatNextToken_(Token::kPow);
-		auto expression = ParseFactor_();
-		result = MakeAstNode<BinaryExpressionAstNode>(Operation::kPow, result, expression);
-	}
-	return result;
-}
-
-/// Factor = NUMBER | TEXT | IDENT | '(' ExpressionAstNode ')'
-///        | IDENT '(' [ExpressionList] ')'
-ExpressionAstNodePtr SyntaxParser::ParseFactor_() {
-	// TRUE & FALSE
-	if (next_lexeme_.OfType(Token::kTrue)) {
-		VerifyAndEatNextToken_(Token::kTrue);
-		return MakeAstNode<BooleanAstNode>(true);
-	} else if (next_lexeme_.OfType(Token::kFalse)) {
-		VerifyAndEatNextToken_(Token::kFalse);
-		return MakeAstNode<BooleanAstNode>(false);
-	}
-
-	// NUMBER
-	if (next_lexeme_.OfType(Token::kNumber)) {
-		auto value = next_lexeme_.value;
-		VerifyAndEatNextToken_(Token::kNumber);
-		return MakeAstNode<NumberAstNode>(std::stod(value));
-	}
-
-	// TEXT
-	if (next_lexeme_.OfType(Token::kText)) {
-		auto value = next_lexeme_.value;
-		VerifyAndEatNextToken_(Token::kText);
-		return MakeAstNode<TextAstNode>(value);
-	}
+	const auto thread_count = static_cast<size_t>(pool->getThreadCount());
 
-	// ('-' | 'NOT') Factor
-	if (next_lexeme_.OfTypeIn({Token::kSub, Token::kNot})) {
-		Operation operation = Operation::kNone;
-		if (next_lexeme_.OfType(Token::kSub)) {
-			operation = Operation::kSub;
-			VerifyAndEatNextToken_(Token::kSub);
-		} else if (next_lexeme_.OfType(Token::kNot)) {
-			operation = Operation::kNot;
-			VerifyAndEatNextToken_(Token::kNot);
-		}
-		auto expression = ParseFactor_();
-		return MakeAstNode<UnaryExpressionAstNode>(operation, expression);
-	}
+	const auto batch_count = std::min(starts.size(), thread_count * kBatchesPerThread);
+	const auto batch_tokens = (tokens_.Size() - starts.front() + batch_count - 1) / batch_count;
 
-	// IDENT ['(' [ExpressionList] ')']
-	if (next_lexeme_.OfType(Token::kIdentifier)) {
-		auto name = next_lexeme_.value;
-		if (auto array = GetArray_(name)) {
-			VerifyAndEatNextToken_(Token::kIdentifier);
-			VerifyAndEatNextToken_(Token::kLeftPar);
-			auto expression = ParseExpression_();
-			VerifyAndEatNextToken_(Token::kRightPar);
-			return MakeAstNode<ItemAstNode>(array, expression);
+	// у каждого пакета своя арена: Arena не потокобезопасна
+	std::vector<std::unique_ptr<Arena>> arenas;
+	for (size_t first = 0, last = 0; first < starts.size(); first = last) {
+		last = first + 1;
+		while (last < starts.size() && starts[last] - starts[first] < batch_tokens) {
+			++last;
 		}
 
-		VerifyAndEatNextToken_(Token::kIdentifier);
-		if (next_lexeme_.OfType(Token::kLeftPar)) {
-			std::vector<ExpressionAstNodePtr> arguments;
-			VerifyAndEatNextToken_(Token::kLeftPar);
-			if (next_lexeme_.OfTypeIn(
-				{
-					Token::kTrue, Token::kFalse, Token::kNumber, Token::kText,
-					Token::kIdentifier, Token::kSub, Token::kNot, Token::kLeftPar,
-				}
-			)) {
-				auto expression = ParseExpression_();
-				arguments.push_back(expression);
-				while (next_lexeme_.OfType(Token::kComma)) {
-					VerifyAndEatNextToken_(Token::kComma);
-					expression = ParseExpression_();
-					arguments.push_back(expression);
+		auto& arena = *arenas.emplace_back(std::make_unique<Arena>());
+		pool->async([this, &starts, &parsed, &arena, first, last] {
+			TraceThread trace_thread;
+			TRACE(ParseSubroutines);
+
+			SubroutineParser parser{tokens_, arena};
+			for (size_t i = first; i < last; ++i) {
+				parsed[i] = parser.Parse(starts[i]);
+				// последовательный разбор остановился бы на этой ошибке
+				if (parsed[i]->error.has_value()) {
+					break;
 				}
 			}
-			VerifyAndEatNextToken_(Token::kRightPar);
-
-			auto applier = MakeAstNode<ApplyAstNode>(nullptr, arguments);
-			applier->SetType(GetIdentifierType(name));
-
-			auto callee = SafeGetSubroutine_(name);
-			if (callee == nullptr) {
-				unresolved_links_[name].push_back(applier);
-			}
-
-			applier->SetCallee(callee);
-
-			return applier;
-		}
-		return CreateOrGetLocalVariable_(name, true);
+		});
 	}
+	pool->wait();
 
-	// '(' ExpressionAstNode ')'
-	if (next_lexeme_.OfType(Token::kLeftPar)) {
-		VerifyAndEatNextToken_(Token::kLeftPar);
-		auto expression = ParseExpression_();
-		VerifyAndEatNextToken_(Token::kRightPar);
-		return expression;
+	for (auto& arena : arenas) {
+		program_->arena.Adopt(*arena);
 	}
 
-	throw SyntaxParseError{"Ожидалось NUMBER, TEXT, '-', NOT, IDENT или '(', получено: " + next_lexeme_.value};
+	return parsed;
 }
 
-void SyntaxParser::ParseNewLines_() {
-	VerifyAndEatNextToken_(Token::kNewLine);
-	while (next_lexeme_.OfType(Token::kNewLine)) {
-		VerifyAndEatNextToken_(Token::kNewLine);
+void SyntaxParser::Link_(SubroutineParser::Result& result) {
+	if (!result.name.empty() && subroutines_.contains(NormalizeIdentifier(result.name))) {
+		throw SyntaxParseError(std::string{result.name} + " — подпрограмма с таким именем уже определена");
 	}
-}
-
-void SyntaxParser::VerifyAndEatNextToken_(Token token) {
-	if (!next_lexeme_.OfType(token)) {
-		throw SyntaxParseError{"Ожидалось: " + ToString(token) + ", получено: " + next_lexeme_.value};
-	}
-
-	reader_ >> next_lexeme_;
-}
-
-VariableAstNodePtr SyntaxParser::CreateOrGetLocalVariable_(std::string_view name, bool is_r_value) {
-	auto& locals = current_subroutine_->local_variables;
 
-	if (is_r_value && sAreVariablesNamesEqual(current_subroutine_->GetName(), name)) {
-		throw SyntaxParseError("Имя подпрограммы используется как rvalue");
+	if (result.error.has_value()) {
+		throw SyntaxParseError(*result.error);
 	}
 
-	auto it = std::find_if(locals.begin(), locals.end(), [&name](auto vp) {
-		return sAreVariablesNamesEqual(name, vp->GetName());
-	});
-	if (it != locals.end()) {
-		return *it;
-	}
+	auto subroutine = result.subroutine;
+	AddSubroutine_(subroutine);
 
-	if (is_r_value) {
-		throw SyntaxParseError(std::string{name} + " — переменная ещё не определена");
+	// Вызовы связываются в порядке появления в тексте, поэтому встроенные
+	// подпрограммы попадают в программу в том же порядке, что и при
+	// последовательном разборе. Рекурсивные вызовы находят уже
+	// добавленную подпрограмму.
+	for (auto& [name, apply] : result.calls) {
+		auto callee = SafeGetSubroutine_(name);
+		if (callee == nullptr) {
+			AddUnresolvedLink_(name, apply);
+		}
+		apply->SetCallee(callee);
+		subroutine->calls.push_back(apply);
 	}
 
-	auto variable = MakeAstNode<VariableAstNode>(name);
-	locals.push_back(variable);
-
-	return variable;
-}
-
-VariableAstNodePtr SyntaxParser::GetArray_(std::string_view name) {
-	auto& locals = current_subroutine_->local_variables;
-
-	auto it = std::find_if(locals.begin(), locals.end(), [&name](auto vp) {
-		return sAreVariablesNamesEqual(name, vp->GetName());
-	});
-	if (it != locals.end() && (*it)->OfType(DataType::kArray)) {
-		return *it;
+	if (auto link = unresolved_links_.find(NormalizeIdentifier(subroutine->GetName())); link != unresolved_links_.end()) {
+		for (auto& apply : link->second.appliers) {
+			apply->SetCallee(subroutine);
+		}
+		unresolved_links_.erase(link);
 	}
-
-	return nullptr;
 }
 
 SubroutineAstNodePtr SyntaxParser::SafeGetSubroutine_(std::string_view name) {
-	for (auto subroutine : program_->subroutines) {
-		if (sAreVariablesNamesEqual(subroutine->GetName(), name)) {
-			return subroutine;
-		}
+	if (auto it = subroutines_.find(NormalizeIdentifier(name)); it != subroutines_.end()) {
+		return it->second;
 	}
 
 	for (auto& builtin : builtin_subroutines_) {
 		if (std::get<0>(builtin) == name) {
-			auto subroutine = MakeAstNode<SubroutineAstNode>(std::get<0>(builtin), std::get<1>(builtin));
+			std::vector<std::string_view> parameters;
+			for (const auto& parameter : std::get<1>(builtin)) {
+				parameters.push_back(Intern_(parameter));
+			}
+			auto subroutine = MakeAstNode<SubroutineAstNode>(program_->arena, Intern_(std::get<0>(builtin)), parameters);
 			subroutine->is_builtin = true;
 			subroutine->is_returning_value = std::get<2>(builtin);
-			program_->subroutines.push_back(subroutine);
+			AddSubroutine_(subroutine);
 			return subroutine;
 		}
 	}
@@ -616,4 +221,18 @@ SubroutineAstNodePtr SyntaxParser::SafeGetSubroutine_(std::string_view name) {
 	return nullptr;
 }
 
+void SyntaxParser::AddSubroutine_(SubroutineAstNodePtr subroutine) {
+	program_->subroutines.push_back(subroutine);
+	subroutines_.emplace(NormalizeIdentifier(subroutine->GetName()), subroutine);
+}
+
+void SyntaxParser::AddUnresolvedLink_(std::string_view name, ApplyAstNodePtr apply) {
+	auto it = unresolved_links_.find(NormalizeIdentifier(name));
+	if (it == unresolved_links_.end()) {
+		const auto interned = Intern_(name);
+		it = unresolved_links_.emplace(NormalizeIdentifier(interned), UnresolvedLink{interned, {}}).first;
+	}
+	it->second.appliers.push_back(apply);
+}
+
 }  // namespace bsq
@@ -1,65 +1,90 @@
 #pragma once
 
 #include <filesystem>
-#include <list>
-#include <map>
+#include <iostream>
+#include <optional>
 #include <string>
 #include <string_view>
 #include <tuple>
+#include <unordered_map>
 #include <vector>
 
 #include "ast.hpp"
-#include "lexeme.hpp"
 #include "lexeme_reader.hpp"
+#include "subroutine_parser.hpp"
+#include "token_buffer.hpp"
+
+
+namespace llvm {
+
+class ThreadPool;
+
+}  // namespace llvm
 
 
 namespace bsq {
 
+/// @brief Синтаксический анализатор программы
+///
+/// Программа — последовательность подпрограмм. Начала подпрограмм
+/// находятся предварительным просмотром лексем, сами подпрограммы
+/// разбираются независимо (в больших программах — параллельно),
+/// после чего они по порядку добавляются в программу и их вызовы
+/// связываются. Результат и сообщения об ошибках такие же, как
+/// при последовательном разборе.
 class SyntaxParser {
 public:
-	explicit SyntaxParser(const std::filesystem::path& filename);
+	/// Сообщения об ошибках выводятся в @p errors
+	explicit SyntaxParser(const std::filesystem::path& filename, std::ostream& errors = std::cerr);
 
-	ProgramAstNodePtr Parse();
+	/// Большие программы лексируются и разбираются потоками @p pool;
+	/// если он nullptr, всё выполняется в вызывающем потоке
+	ProgramAstNodeOwner Parse(llvm::ThreadPool* pool = nullptr);
 
 private:
-	void ParseProgram_();
-	void ParseSubroutine_();
-	StatementAstNodePtr ParseStatements_();
-	StatementAstNodePtr ParseInput_();
-	StatementAstNodePtr ParsePrint_();
-	StatementAstNodePtr ParseLet_();
-	StatementAstNodePtr ParseDim_();
-	StatementAstNodePtr ParseIf_();
-	StatementAstNodePtr ParseWhile_();
-	StatementAstNodePtr ParseFor_();
-	StatementAstNodePtr ParseCall_();
-	ExpressionAstNodePtr ParseExpression_();
-	ExpressionAstNodePtr ParseAddition_();
-	ExpressionAstNodePtr ParseMultiplication_();
-	ExpressionAstNodePtr ParsePower_();
-	ExpressionAstNodePtr ParseFactor_();
-
-	void ParseNewLines_();
-
-	void VerifyAndEatNextToken_(Token token);
-
-	/// Создаёт локальную переменную или возвращает уже существующую
-	VariableAstNodePtr CreateOrGetLocalVariable_(std::string_view name, bool is_r_value);
-	VariableAstNodePtr GetArray_(std::string_view name);
-
-	/// Находит подпрограмму и проверяет типы аргументов и параметров
+	/// Program [NewLines] { Subroutine NewLines }
+	///
+	/// Если @p pool не nullptr, подпрограммы разбираются его потоками
+	void ParseProgram_(llvm::ThreadPool* pool);
+
+	/// Индексы лексем, с которых, по-видимому, начинаются подпрограммы
+	[[nodiscard]] std::vector<size_t> FindSubroutines_(size_t position) const;
+
+	/// Разбирает подпрограммы, начинающиеся с @p starts, потоками @p pool
+	std::vector<std::optional<SubroutineParser::Result>> ParseSubroutines_(const std::vector<size_t>& starts, llvm::ThreadPool* pool);
+
+	/// Добавляет разобранную подпрограмму в программу и связывает её вызовы
+	void Link_(SubroutineParser::Result& result);
+
+	/// Находит подпрограмму, в том числе встроенную
 	SubroutineAstNodePtr SafeGetSubroutine_(std::string_view name);
 
+	void AddSubroutine_(SubroutineAstNodePtr subroutine);
+	void AddUnresolvedLink_(std::string_view name, ApplyAstNodePtr apply);
+
+	/// Копирует строку в арену программы
+	std::string_view Intern_(std::string_view text) {
+		return program_->arena.Intern(text);
+	}
+
 private:
-	ProgramAstNodePtr program_;  ///< Корень дерева
+	ProgramAstNodeOwner program_;  ///< Корень дерева, владеет ареной узлов
 
-	SubroutineAstNodePtr current_subroutine_;
+	/// Все подпрограммы программы, включая использованные встроенные.
+	/// Ключи — имена из арены без суффикса типа.
+	std::unordered_map<std::string_view, SubroutineAstNodePtr> subroutines_;
 
 	LexemeReader reader_;
-	Lexeme next_lexeme_;
+	TokenBuffer tokens_;
+	std::ostream& errors_;
+
+	struct UnresolvedLink {
+		std::string_view name;  ///< Имя в том виде, в каком оно встретилось первым
+		std::vector<ApplyAstNodePtr> appliers;
+	};
 
-	/// Неразрешённые ссылки: имя подпрограммы -> список объектов ApplyAstNode, на которые она ссылается
-	std::map<std::string, std::list<ApplyAstNodePtr>> unresolved_links_;
+	/// Неразрешённые ссылки: имя подпрограммы -> объекты ApplyAstNode, которые на неё ссылаются
+	std::unordered_map<std::string_view, UnresolvedLink> unresolved_links_;
 
 	using BuiltinSubroutine = std::tuple<std::string, std::vector<std::string>, bool>;
 	std::vector<BuiltinSubroutine> builtin_subroutines_;
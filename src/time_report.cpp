@@ -0,0 +1,207 @@
+#include "time_report.hpp"
+
+#include <iomanip>
+#include <string_view>
+
+#include <llvm/IR/Module.h>
+#include <llvm/Support/JSON.h>
+#include <llvm/Support/raw_os_ostream.h>
+
+#include <sys/resource.h>
+
+
+namespace {
+
+using namespace bsq;
+
+/// Ширина столбцов текстового отчёта
+constexpr size_t kNameWidth = 24;
+constexpr size_t kTimeWidth = 12;
+
+/// Имя фазы в JSON
+const char* sPhaseKey(TimeReport::Phase phase) {
+	switch (phase) {
+	case TimeReport::Phase::kParse: return "parse";
+	case TimeReport::Phase::kCheck: return "check";
+	case TimeReport::Phase::kFold: return "fold";
+	case TimeReport::Phase::kEmit: return "emit";
+	case TimeReport::Phase::kLinkProgram: return "link_program";
+	case TimeReport::Phase::kLinkLibrary: return "link_library";
+	case TimeReport::Phase::kOptimize: return "optimize";
+	case TimeReport::Phase::kPrint: return "print";
+	default: return "undefined";
+	}
+}
+
+/// Имя фазы в текстовом отчёте
+const char* sPhaseName(TimeReport::Phase phase) {
+	switch (phase) {
+	case TimeReport::Phase::kParse: return "синтаксический анализ";
+	case TimeReport::Phase::kCheck: return "проверка типов";
+	case TimeReport::Phase::kFold: return "свёртка констант";
+	case TimeReport::Phase::kEmit: return "генерация IR";
+	case TimeReport::Phase::kLinkProgram: return "связывание программы";
+	case TimeReport::Phase::kLinkLibrary: return "связывание библиотеки";
+	case TimeReport::Phase::kOptimize: return "оптимизация";
+	case TimeReport::Phase::kPrint: return "вывод .ll";
+	default: return "?";
+	}
+}
+
+/// Дополняет @p text пробелами до @p width знаков; std::setw считает
+/// байты, а не знаки UTF-8
+std::string sPad(std::string_view text, size_t width) {
+	size_t length = 0;
+	for (const char c : text) {
+		length += (static_cast<unsigned char>(c) & 0xC0) != 0x80;
+	}
+
+	std::string padded{text};
+	padded.append(width > length ? width - length : 0, ' ');
+	return padded;
+}
+
+/// Пиковый RSS процесса в килобайтах
+long sPeakRssKilobytes() {
+	rusage usage{};
+	getrusage(RUSAGE_SELF, &usage);
+	return usage.ru_maxrss;
+}
+
+}  // namespace
+
+
+namespace bsq {
+
+TimeReport::Scope::Scope(TimeReport* report, Phase phase)
+	: report_{report}
+	, phase_{phase}
+{
+	if (report_ != nullptr) {
+		start_ = llvm::TimeRecord::getCurrentTime(true);
+	}
+}
+
+TimeReport::Scope::~Scope() {
+	if (report_ != nullptr) {
+		auto time = llvm::TimeRecord::getCurrentTime(false);
+		time -= start_;
+		report_->phases_[static_cast<size_t>(phase_)] += time;
+	}
+}
+
+TimeReport::TimeReport(std::filesystem::path source)
+	: source_{std::move(source)}
+	, start_{llvm::TimeRecord::getCurrentTime(true)}
+{
+}
+
+void TimeReport::SetModuleStatistics(const llvm::Module& module) {
+	ModuleStatistics statistics;
+	for (const auto& function : module) {
+		if (function.isDeclaration()) {
+			continue;
+		}
+		++statistics.functions;
+		statistics.basic_blocks += function.size();
+		statistics.instructions += function.getInstructionCount();
+	}
+	module_statistics_ = statistics;
+}
+
+void TimeReport::Print(std::ostream& out, TimeReportFormat format, bool is_compiled) const {
+	if (format == TimeReportFormat::kJson) {
+		PrintJson_(out, is_compiled);
+	} else {
+		PrintText_(out, is_compiled);
+	}
+}
+
+void TimeReport::PrintText_(std::ostream& out, bool is_compiled) const {
+	auto total = llvm::TimeRecord::getCurrentTime(false);
+	total -= start_;
+
+	const auto flags = out.flags();
+	const auto precision = out.precision();
+	out << std::fixed << std::setprecision(4);
+
+	out << "Отчёт о компиляции " << source_.string() << (is_compiled ? "" : " (не скомпилирован)") << std::endl;
+	out << "  " << sPad("фаза", kNameWidth) << sPad("стена, с", kTimeWidth) << "ЦП, с" << std::endl;
+	for (size_t i = 0; i < phases_.size(); ++i) {
+		const auto& time = phases_[i];
+		out << "  " << sPad(sPhaseName(static_cast<Phase>(i)), kNameWidth)
+			<< std::left << std::setw(kTimeWidth) << time.getWallTime() << time.getProcessTime() << std::endl;
+	}
+	out << "  " << sPad("всего", kNameWidth)
+		<< std::left << std::setw(kTimeWidth) << total.getWallTime() << total.getProcessTime() << std::endl;
+
+	out << "  пиковый RSS: " << sPeakRssKilobytes() << " КБ" << std::endl;
+
+	if (ast_node_counts_.has_value()) {
+		out << "  узлы AST:";
+		for (size_t i = 0; i < ast_node_counts_->size(); ++i) {
+			if (const auto count = (*ast_node_counts_)[i]; count != 0) {
+				out << ' ' << ToString(static_cast<AstNodeType>(i)) << ' ' << count;
+			}
+		}
+		out << std::endl;
+	}
+
+	if (module_statistics_.has_value()) {
+		out << "  LLVM IR: функций " << module_statistics_->functions
+			<< ", базовых блоков " << module_statistics_->basic_blocks
+			<< ", инструкций " << module_statistics_->instructions << std::endl;
+	}
+
+	out.flags(flags);
+	out.precision(precision);
+}
+
+void TimeReport::PrintJson_(std::ostream& out, bool is_compiled) const {
+	auto total = llvm::TimeRecord::getCurrentTime(false);
+	total -= start_;
+
+	const auto time_value = [](const llvm::TimeRecord& time) {
+		return llvm::json::Object{
+			{"wall", time.getWallTime()},
+			{"cpu", time.getProcessTime()},
+		};
+	};
+
+	llvm::json::Object phases;
+	for (size_t i = 0; i < phases_.size(); ++i) {
+		phases[sPhaseKey(static_cast<Phase>(i))] = time_value(phases_[i]);
+	}
+
+	llvm::json::Object report{
+		{"file", source_.string()},
+		{"compiled", is_compiled},
+		{"phases", std::move(phases)},
+		{"total", time_value(total)},
+		{"peak_rss_kb", static_cast<int64_t>(sPeakRssKilobytes())},
+	};
+
+	if (ast_node_counts_.has_value()) {
+		llvm::json::Object nodes;
+		for (size_t i = 0; i < ast_node_counts_->size(); ++i) {
+			if (const auto type = static_cast<AstNodeType>(i); type != AstNodeType::kEmpty) {
+				nodes[ToString(type)] = static_cast<int64_t>((*ast_node_counts_)[i]);
+			}
+		}
+		report["ast_nodes"] = std::move(nodes);
+	}
+
+	if (module_statistics_.has_value()) {
+		report["llvm"] = llvm::json::Object{
+			{"functions", static_cast<int64_t>(module_statistics_->functions)},
+			{"basic_blocks", static_cast<int64_t>(module_statistics_->basic_blocks)},
+			{"instructions", static_cast<int64_t>(module_statistics_->instructions)},
+		};
+	}
+
+	// один отчёт — одна строка: отчёты пакета удобно читать построчно
+	llvm::raw_os_ostream json_out{out};
+	json_out << llvm::json::Value(std::move(report)) << '\n';
+}
+
+}  // namespace bsq
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <filesystem>
+#include <optional>
+#include <ostream>
+#include <string>
+
+#include <llvm/Support/Timer.h>
+
+#include "ast.hpp"
+
+
+namespace llvm {
+
+class Module;
+
+}  // namespace llvm
+
+
+namespace bsq {
+
+enum class TimeReportFormat {
+	kText,
+	kJson,
+};
+
+/// @brief Отчёт о компиляции файла (--time-report)
+///
+/// Время стены и ЦП по фазам компиляции, пиковый RSS процесса, число
+/// узлов AST каждого типа и размер итогового модуля LLVM. Время ЦП —
+/// время всего процесса, поэтому в пакетном режиме с несколькими потоками
+/// в него входит и компиляция других файлов.
+class TimeReport {
+public:
+	/// Фазы компиляции в порядке выполнения
+	enum class Phase {
+		kParse,        ///< SyntaxParser::Parse, вместе с лексическим анализом
+		kCheck,        ///< SemanticChecker::Check
+		kFold,         ///< ConstantFolder::Fold
+		kEmit,         ///< IrGenerator::Emit
+		kLinkProgram,  ///< связывание модуля программы
+		kLinkLibrary,  ///< связывание библиотеки времени выполнения
+		kOptimize,     ///< конвейер оптимизации, см. OptimizationLevel
+		kPrint,        ///< проверка и вывод модуля в .ll
+		kCount,
+	};
+
+	/// Добавляет время от создания до разрушения к фазе; ничего не делает,
+	/// если @p report — nullptr
+	class Scope {
+	public:
+		Scope(TimeReport* report, Phase phase);
+		~Scope();
+
+		Scope(const Scope&) = delete;
+		Scope& operator=(const Scope&) = delete;
+
+	private:
+		TimeReport* report_;
+		Phase phase_;
+		llvm::TimeRecord start_;
+	};
+
+	explicit TimeReport(std::filesystem::path source);
+
+	void SetAstNodeCounts(const AstNodeCounts& counts) { ast_node_counts_ = counts; }
+	void SetModuleStatistics(const llvm::Module& module);
+
+	void Print(std::ostream& out, TimeReportFormat format, bool is_compiled) const;
+
+private:
+	struct ModuleStatistics {
+		size_t functions = 0;  ///< Определённые функции, без объявлений
+		size_t basic_blocks = 0;
+		size_t instructions = 0;
+	};
+
+	void PrintText_(std::ostream& out, bool is_compiled) const;
+	void PrintJson_(std::ostream& out, bool is_compiled) const;
+
+private:
+	std::filesystem::path source_;
+	llvm::TimeRecord start_;  ///< Начало компиляции, от него отсчитывается общее время
+	std::array<llvm::TimeRecord, static_cast<size_t>(Phase::kCount)> phases_;
+	std::optional<AstNodeCounts> ast_node_counts_;
+	std::optional<ModuleStatistics> module_statistics_;
+};
+
+}  // namespace bsq
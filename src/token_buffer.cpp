@@ -0,0 +1,71 @@
+#include "token_buffer.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+
+
+namespace bsq {
+
+TokenBuffer::TokenBuffer(std::string_view source)
+	: source_{source}
+{
+	if (source_.size() > kMaxSourceSize) {
+		throw std::length_error{"исходный текст больше " + std::to_string(kMaxSourceSize) + " байт"};
+	}
+
+	// оценка: в среднем лексема занимает около четырёх символов
+	Reserve(source_.size() / 4 + 1);
+}
+
+void TokenBuffer::Reserve(std::size_t capacity) {
+	tokens_.reserve(capacity);
+	offsets_.reserve(capacity);
+	lengths_.reserve(capacity);
+	lines_.reserve(capacity);
+}
+
+void TokenBuffer::Append(const Lexeme& lexeme, std::uint32_t line) {
+	tokens_.push_back(lexeme.token);
+	lines_.push_back(line);
+
+	// значение Eof не является частью исходного текста
+	if (lexeme.OfType(Token::kEof)) {
+		offsets_.push_back(static_cast<std::uint32_t>(source_.size()));
+		lengths_.push_back(0);
+		return;
+	}
+
+	offsets_.push_back(static_cast<std::uint32_t>(lexeme.value.data() - source_.data()));
+	lengths_.push_back(static_cast<std::uint32_t>(lexeme.value.size()));
+}
+
+void TokenBuffer::Resize(std::size_t size) {
+	tokens_.resize(size);
+	offsets_.resize(size);
+	lengths_.resize(size);
+	lines_.resize(size);
+}
+
+void TokenBuffer::Assign(std::size_t index, const TokenBuffer& other, std::uint32_t line_offset) {
+	const auto size = other.Size() - 1;
+	const auto source_offset = static_cast<std::uint32_t>(other.source_.data() - source_.data());
+
+	std::copy_n(other.tokens_.begin(), size, tokens_.begin() + static_cast<std::ptrdiff_t>(index));
+	std::copy_n(other.lengths_.begin(), size, lengths_.begin() + static_cast<std::ptrdiff_t>(index));
+	for (std::size_t i = 0; i < size; ++i) {
+		offsets_[index + i] = other.offsets_[i] + source_offset;
+		lines_[index + i] = other.lines_[i] + line_offset;
+	}
+}
+
+std::string_view TokenBuffer::GetValue(std::size_t index) const {
+	if (tokens_[index] == Token::kEof) {
+		return "EOF";
+	}
+
+	return source_.substr(offsets_[index], lengths_[index]);
+}
+
+}  // namespace bsq
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "lexeme.hpp"
+
+
+namespace bsq {
+
+/// Распределитель, при resize не обнуляющий новые элементы: их сразу
+/// перезаписывает TokenBuffer::Assign, и страницы памяти впервые
+/// затрагиваются уже там, одновременно в нескольких потоках
+template <typename T>
+class DefaultInitAllocator : public std::allocator<T> {
+public:
+	DefaultInitAllocator() = default;
+
+	template <typename U>
+	DefaultInitAllocator(const DefaultInitAllocator<U>& /*other*/) noexcept {}
+
+	template <typename U>
+	void construct(U* p) {
+		::new (static_cast<void*>(p)) U;
+	}
+
+	template <typename U, typename... Args>
+	void construct(U* p, Args&& ... args) {
+		::new (static_cast<void*>(p)) U(std::forward<Args>(args)...);
+	}
+};
+
+
+/// @brief Все лексемы исходного текста в виде структуры массивов
+///
+/// Виды лексем, их смещения и длины в исходном тексте и номера строк
+/// хранятся в отдельных массивах. Синтаксический анализатор обходит
+/// буфер по индексу и может заглядывать вперёд на любое число лексем.
+/// Последняя лексема буфера — всегда Eof.
+class TokenBuffer {
+public:
+	/// Смещения и длины лексем хранятся в uint32_t, поэтому текст
+	/// длиннее этого числа байт буфер не вмещает
+	static constexpr std::size_t kMaxSourceSize = UINT32_MAX;
+
+	TokenBuffer() = default;
+
+	/// @p source — не длиннее kMaxSourceSize, иначе std::length_error
+	explicit TokenBuffer(std::string_view source);
+
+	void Append(const Lexeme& lexeme, std::uint32_t line);
+
+	void Reserve(std::size_t capacity);
+
+	/// Меняет число лексем; добавленные лексемы заполняются через Assign
+	void Resize(std::size_t size);
+
+	/// Копирует все лексемы @p other, кроме завершающей Eof, начиная
+	/// с индекса @p index. Текст @p other должен быть частью текста этого
+	/// буфера; номера строк @p other сдвигаются на @p line_offset.
+	/// Непересекающиеся диапазоны можно заполнять одновременно.
+	void Assign(std::size_t index, const TokenBuffer& other, std::uint32_t line_offset);
+
+	[[nodiscard]] std::size_t Size() const { return tokens_.size(); }
+
+	[[nodiscard]] Token GetToken(std::size_t index) const { return tokens_[index]; }
+	[[nodiscard]] std::string_view GetValue(std::size_t index) const;
+	[[nodiscard]] std::uint32_t GetLine(std::size_t index) const { return lines_[index]; }
+	[[nodiscard]] Lexeme GetLexeme(std::size_t index) const { return {GetToken(index), GetValue(index)}; }
+
+private:
+	std::string_view source_;
+
+	template <typename T>
+	using Array = std::vector<T, DefaultInitAllocator<T>>;
+
+	Array<Token> tokens_;
+	Array<std::uint32_t> offsets_;
+	Array<std::uint32_t> lengths_;
+	Array<std::uint32_t> lines_;
+};
+
+}  // namespace bsq
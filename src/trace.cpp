@@ -0,0 +1,66 @@
+#include "trace.hpp"
+
+#include <atomic>
+
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/TimeProfiler.h>
+#include <llvm/Support/raw_ostream.h>
+
+
+namespace {
+
+/// Записываются все события, какими бы короткими они ни были
+constexpr unsigned kTraceGranularityMicroseconds = 0;
+
+/// Идёт ли трассировка; буферы потоков создаются, только если идёт
+std::atomic<bool> is_tracing = false;
+
+}  // namespace
+
+
+namespace bsq {
+
+bool StartTrace(std::ostream& errors) {
+#ifdef BSQ_TRACING
+	llvm::timeTraceProfilerInitialize(kTraceGranularityMicroseconds, "bsq");
+	is_tracing = true;
+	return true;
+#else
+	errors << "--trace: компилятор собран без BSQ_TRACING" << std::endl;
+	return false;
+#endif
+}
+
+bool FinishTrace(const std::filesystem::path& path, std::ostream& errors) {
+	if (!is_tracing.exchange(false)) {
+		return false;
+	}
+
+	std::error_code ec;
+	llvm::raw_fd_ostream out{path.string(), ec, llvm::sys::fs::OF_Text};
+	if (!ec) {
+		llvm::timeTraceProfilerWrite(out);
+	}
+	llvm::timeTraceProfilerCleanup();
+
+	if (ec) {
+		errors << path.string() << ": " << ec.message() << std::endl;
+		return false;
+	}
+	return true;
+}
+
+TraceThread::TraceThread() {
+	if (is_tracing && !llvm::timeTraceProfilerEnabled()) {
+		llvm::timeTraceProfilerInitialize(kTraceGranularityMicroseconds, "bsq");
+		is_tracing_ = true;
+	}
+}
+
+TraceThread::~TraceThread() {
+	if (is_tracing_) {
+		llvm::timeTraceProfilerFinishThread();
+	}
+}
+
+}  // namespace bsq
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <filesystem>
+#include <iostream>
+
+#ifdef BSQ_TRACING
+#include <string>
+
+#include <llvm/Support/TimeProfiler.h>
+#endif
+
+
+/// @file
+/// @brief Трассировка компилятора в формате Chrome Trace Event
+///
+/// Событие — время жизни области видимости, отмеченной TRACE. События
+/// пишутся в буферы потоков llvm::TimeTraceProfiler, в них же попадают
+/// проходы LLVM, и по окончании компиляции выводятся в файл JSON,
+/// который открывают chrome://tracing и Perfetto. Без BSQ_TRACING
+/// (cmake -DBSQ_TRACING=OFF) макросы не компилируются ни во что.
+
+#ifdef BSQ_TRACING
+#define TRACE(t) llvm::TimeTraceScope _t{(#t)}
+/// Событие с подробностью @p detail; она вычисляется, только если трассировка идёт
+#define TRACE_DETAIL(t, detail) llvm::TimeTraceScope _t{(#t), [&] { return std::string{detail}; }}
+#else
+#define TRACE(t) (void)(#t)
+#define TRACE_DETAIL(t, detail) (void)(#t)
+#endif
+
+
+namespace bsq {
+
+/// Начинает трассировку; вызывается потоком, который затем вызовет FinishTrace
+bool StartTrace(std::ostream& errors = std::cerr);
+
+/// Записывает события всех потоков в @p path и заканчивает трассировку
+bool FinishTrace(const std::filesystem::path& path, std::ostream& errors = std::cerr);
+
+/// @brief Записывает события потока пула, пока существует
+///
+/// Создаётся в начале задачи пула потоков: буфер событий у каждого
+/// потока свой, и без TraceThread события задачи не попадут в трассировку.
+class TraceThread {
+public:
+	TraceThread();
+	~TraceThread();
+
+	TraceThread(const TraceThread&) = delete;
+	TraceThread& operator=(const TraceThread&) = delete;
+
+private:
+	bool is_tracing_ = false;
+};
+
+}  // namespace bsq
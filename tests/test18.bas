@@ -0,0 +1,19 @@
+' Проверка индексов: компилировать с --bounds-check.
+' При k от 1 до n печатается A(k), при k = n + 1 — ошибка
+' bsq_index_out_of_range «индекс n + 1 вне массива длины n»
+SUB Main
+  INPUT n
+  DIM A(n)
+  FOR i = 1 TO n + 1
+    FOR j = 1 TO n + 1
+      FOR l = 1 TO n + 1
+        LET A(l) = A(l) + 1
+      END FOR
+      LET A(j) = A(j) + j
+    END FOR
+    LET A(i) = A(i) * 2
+  END FOR
+
+  INPUT k
+  PRINT A(k)
+END SUB
@@ -0,0 +1,47 @@
+' Дробный шаг FOR: на k-й итерации счётчик равен begin + k * step,
+' и число итераций не зависит от того, присваивает ли тело счётчику
+SUB Main
+  ' 10 итераций, после цикла y = 1
+  LET n = 0
+  FOR y = 0 TO 1 STEP 0.1
+    LET n = n + 1
+  END FOR
+  PRINT n
+  PRINT y
+
+  ' присваивание прежнего значения не меняет цикл: тоже 10 итераций
+  LET n = 0
+  FOR y = 0 TO 1 STEP 0.1
+    LET y = y
+    LET n = n + 1
+  END FOR
+  PRINT n
+
+  ' 0.1 * 3 = 0.30000000000000004, и 3 * 0.1 уже не меньше границы:
+  ' 3 итерации
+  LET n = 0
+  FOR x = 0 TO 0.1 * 3 STEP 0.1
+    PRINT x
+    LET n = n + 1
+  END FOR
+  PRINT n
+
+  ' 0.48000000000000004 / 0.01 округляется до 48, но и 48 * 0.01 = 0.48
+  ' меньше границы: 49 итераций
+  LET n = 0
+  FOR x = 0 TO 0.48000000000000004 STEP 0.01
+    LET n = n + 1
+  END FOR
+  PRINT n
+
+  ' счётчик, изменённый телом, — новое начало отсчёта: 0.5, 2, 3.5
+  FOR u = 0.5 TO 5 STEP 0.5
+    PRINT u
+    LET u = u + 1
+  END FOR
+
+  ' обратный шаг: 2, 1.5, 1, 0.5
+  FOR z = 2 TO 0 STEP -0.5
+    PRINT z
+  END FOR
+END SUB
@@ -0,0 +1,37 @@
+' INTEGER: переменные с '%', '\', MOD, переполнение по модулю 2^64,
+' FIX% и CDBL, счётчик FOR типа INTEGER, в том числе у пределов i64
+SUB Half%(n%)
+  LET Half% = n% \ 2
+END SUB
+
+SUB Main
+  LET a% = 17
+  LET b% = -5
+  PRINT a% \ b%
+  PRINT a% MOD b%
+  PRINT -a% \ 5
+  PRINT -a% MOD 5
+  PRINT a% * b% + 3
+  PRINT a% / 2
+  PRINT Half%(a%)
+  LET big% = 9223372036854775807
+  PRINT big% + 1
+  PRINT FIX%(-2.75)
+  PRINT FIX%(100000000000000000000000000000)
+  PRINT CDBL(a%) / 4
+  LET s% = 0
+  FOR i% = 10 TO 0 STEP -3
+    LET s% = s% + i%
+  END FOR
+  PRINT s%
+  ' у пределов i64 шаг за предел завершает цикл, а не переносит счётчик
+  FOR i% = 9223372036854775800 TO 9223372036854775807 STEP 5
+    PRINT i%
+  END FOR
+  FOR i% = -9223372036854775800 TO -9223372036854775807 STEP -5
+    PRINT i%
+  END FOR
+  IF (a% > b%) AND (a% <> 0) THEN
+    PRINT "ok"
+  END IF
+END SUB
@@ -0,0 +1,9 @@
+' Целочисленное деление на ноль: при d = 3 программа завершается
+' сообщением bsq_division_by_zero
+SUB Main
+  INPUT d
+  LET k% = FIX%(d) - 3
+  LET n% = 100
+  PRINT n% \ k%
+  PRINT n% MOD k%
+END SUB
@@ -0,0 +1,6 @@
+' Ошибка типов: INTEGER и NUMBER не смешиваются без FIX% и CDBL
+SUB Main
+  LET x = 7
+  LET n% = x
+  PRINT n% + 0.5
+END SUB
@@ -0,0 +1,33 @@
+' Массивы, размер которых известен при выполнении: DIM A(n),
+' REDIM PRESERVE с сохранением старых элементов и нулями в новых, DIM A(0)
+SUB Main
+  INPUT n
+  DIM A(n)
+  FOR i = 1 TO n + 1
+    LET A(i) = i * 10
+  END FOR
+
+  ' рост: A(1..n) сохраняются, A(n+1..2n) равны 0
+  REDIM PRESERVE A(2 * n)
+  FOR i = 1 TO 2 * n + 1
+    PRINT A(i)
+  END FOR
+
+  ' уменьшение сохраняет начало, повторный рост заполняет нулями
+  REDIM PRESERVE A(1)
+  REDIM PRESERVE A(3)
+  PRINT A(1)
+  PRINT A(2)
+  PRINT A(3)
+
+  ' REDIM без PRESERVE обнуляет массив
+  REDIM A(n)
+  PRINT A(1)
+
+  ' пустые массивы: постоянного размера и растущий
+  DIM Z(0)
+  DIM E(0)
+  REDIM PRESERVE E(2)
+  LET E(2) = 7
+  PRINT E(1) + E(2)
+END SUB